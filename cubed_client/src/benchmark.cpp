@@ -0,0 +1,698 @@
+#include "benchmark.h"
+#include "block_accessor.h"
+#include "chunk.h"
+#include "chunk_grid.h"
+#include "chunk_update.h"
+#include "epoch_manager.h"
+#include "frustum.h"
+#include "job_system.h"
+#include "world.h"
+#include "world_constants.h"
+#include "world_gen/world_gen.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <glm/include/gtc/matrix_transform.hpp>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	template<typename Function>
+	double time_milliseconds(Function function)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	const char* get_layout_name(BlockLayout layout)
+	{
+		switch (layout)
+		{
+			case BlockLayout::LINEAR:
+				return "LINEAR";
+
+			case BlockLayout::Y_MAJOR:
+				return "Y_MAJOR";
+
+			case BlockLayout::MORTON:
+				return "MORTON";
+		}
+
+		return "unknown";
+	}
+
+	// The chunk the world is centered on when it is created
+	void get_spawn_chunk(int& chunk_x, int& chunk_y, int& chunk_z)
+	{
+		auto spawn = WorldGen::get_spawn_pos();
+
+		chunk_x = Chunk::get_chunk_coord(static_cast<int>(std::floor(spawn.x)));
+		chunk_y = Chunk::get_chunk_coord(static_cast<int>(std::floor(spawn.y)));
+		chunk_z = Chunk::get_chunk_coord(static_cast<int>(std::floor(spawn.z)));
+	}
+
+	// Sorts the values
+	double get_percentile(std::vector<double>& values, double fraction)
+	{
+		if (values.empty())
+		{
+			return 0.0;
+		}
+
+		std::sort(values.begin(), values.end());
+		return values[static_cast<std::size_t>(fraction * (values.size() - 1))];
+	}
+}
+
+Benchmark::Benchmark() :
+	m_window{"Cubed benchmark", 800, 600, m_input_manager},
+	m_rendering_engine(m_window)
+{
+}
+
+void Benchmark::run(std::ostream& out)
+{
+	out << std::fixed << std::setprecision(2);
+	out << "Chunk size " << WorldConstants::CHUNK_SIZE << ", " << get_layout_name(WorldConstants::BLOCK_LAYOUT) << " block layout, "
+		<< JobSystem::get_default_num_workers() << " workers\n\n";
+
+	run_chunk_lookups(out);
+	run_chunk_pipeline(out);
+	run_block_queries(out);
+	run_state_scans(out);
+	run_resizes(out);
+	run_time_to_visible(out);
+	run_flights(out);
+}
+
+void Benchmark::run_chunk_lookups(std::ostream& out)
+{
+	// What World kept its chunks in before the grid
+	typedef std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, Chunk*>>> ChunkMap;
+
+	const int NUM_RANDOM_LOOKUPS = 1 << 22;
+
+	out << "Chunk lookups, nanoseconds per lookup\n";
+	out << "radius\tgrid random\tmap random\tgrid neighbours\tmap neighbours\n";
+
+	for (int radius : {4, 8, 16})
+	{
+		EpochManager epochs;
+		ChunkGrid grid{radius, epochs};
+		ChunkMap map;
+
+		for (int x = -radius; x <= radius; ++x)
+		{
+			for (int y = -radius; y <= radius; ++y)
+			{
+				for (int z = -radius; z <= radius; ++z)
+				{
+					auto chunk = std::make_unique<Chunk>(x, y, z);
+					map[x][y][z] = chunk.get();
+					grid.set_slot(x, y, z, std::move(chunk));
+				}
+			}
+		}
+
+		auto map_get = [&map](int x, int y, int z) -> Chunk*
+		{
+			auto it_x = map.find(x);
+
+			if (it_x == map.end())
+			{
+				return nullptr;
+			}
+
+			auto it_y = it_x->second.find(y);
+
+			if (it_y == it_x->second.end())
+			{
+				return nullptr;
+			}
+
+			auto it_z = it_y->second.find(z);
+			return it_z == it_y->second.end() ? nullptr : it_z->second;
+		};
+
+		// Scattered lookups, like queries for arbitrary blocks
+		std::mt19937 random{1};
+		std::uniform_int_distribution<int> coord{-radius, radius};
+		std::vector<std::array<int, 3>> coords(NUM_RANDOM_LOOKUPS);
+
+		for (auto& c : coords)
+		{
+			c = {coord(random), coord(random), coord(random)};
+		}
+
+		std::size_t grid_found = 0;
+		std::size_t map_found = 0;
+
+		auto grid_random = time_milliseconds([&grid, &coords, &grid_found]()
+		{
+			for (auto& c : coords)
+			{
+				grid_found += grid.get(c[0], c[1], c[2]) != nullptr;
+			}
+		});
+
+		auto map_random = time_milliseconds([&map_get, &coords, &map_found]()
+		{
+			for (auto& c : coords)
+			{
+				map_found += map_get(c[0], c[1], c[2]) != nullptr;
+			}
+		});
+
+		// The six neighbours of every chunk, like the check before a chunk is meshed. Chunks on
+		// the edge of the cube have neighbours outside it, so some lookups miss.
+		const std::array<std::array<int, 3>, 6> offsets{{{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}}};
+		int num_neighbour_lookups = 0;
+
+		auto grid_neighbours = time_milliseconds([&grid, &offsets, &grid_found, &num_neighbour_lookups, radius]()
+		{
+			for (int x = -radius; x <= radius; ++x)
+			{
+				for (int y = -radius; y <= radius; ++y)
+				{
+					for (int z = -radius; z <= radius; ++z)
+					{
+						for (auto& offset : offsets)
+						{
+							grid_found += grid.get(x + offset[0], y + offset[1], z + offset[2]) != nullptr;
+							++num_neighbour_lookups;
+						}
+					}
+				}
+			}
+		});
+
+		auto map_neighbours = time_milliseconds([&map_get, &offsets, &map_found, radius]()
+		{
+			for (int x = -radius; x <= radius; ++x)
+			{
+				for (int y = -radius; y <= radius; ++y)
+				{
+					for (int z = -radius; z <= radius; ++z)
+					{
+						for (auto& offset : offsets)
+						{
+							map_found += map_get(x + offset[0], y + offset[1], z + offset[2]) != nullptr;
+						}
+					}
+				}
+			}
+		});
+
+		if (grid_found != map_found)
+		{
+			throw BenchmarkException("Chunk grid and map lookups disagree");
+		}
+
+		auto nanoseconds = [](double milliseconds, int lookups) { return milliseconds * 1000000.0 / lookups; };
+
+		out << radius << '\t' << nanoseconds(grid_random, NUM_RANDOM_LOOKUPS) << '\t' << nanoseconds(map_random, NUM_RANDOM_LOOKUPS)
+			<< '\t' << nanoseconds(grid_neighbours, num_neighbour_lookups) << '\t' << nanoseconds(map_neighbours, num_neighbour_lookups) << '\n';
+	}
+
+	out << '\n';
+}
+
+void Benchmark::run_chunk_pipeline(std::ostream& out)
+{
+	// Every chunk size covers the same blocks, so the totals compare directly across builds
+	const int RADIUS_BLOCKS = 128;
+	int radius = RADIUS_BLOCKS / WorldConstants::CHUNK_SIZE;
+
+	int center_x;
+	int center_y;
+	int center_z;
+	get_spawn_chunk(center_x, center_y, center_z);
+
+	auto for_each_chunk = [radius, center_x, center_y, center_z](auto callback)
+	{
+		for (int x = center_x - radius; x < center_x + radius; ++x)
+		{
+			for (int z = center_z - radius; z < center_z + radius; ++z)
+			{
+				for (int y = center_y - radius; y < center_y + radius; ++y)
+				{
+					callback(x, y, z);
+				}
+			}
+		}
+	};
+
+	// Generating a chunk normally has to work out the terrain heights of its column too
+	WorldGen::evict_column_heights(center_x + 2 * radius + 1, center_z, 0);
+
+	int num_chunks = 0;
+	int num_uniform = 0;
+
+	auto generate = time_milliseconds([&for_each_chunk, &num_chunks, &num_uniform]()
+	{
+		for_each_chunk([&num_chunks, &num_uniform](int x, int y, int z)
+		{
+			auto block_data = BlockData::create();
+			WorldGen::fill_chunk(*block_data, x * WorldConstants::CHUNK_SIZE, y * WorldConstants::CHUNK_SIZE, z * WorldConstants::CHUNK_SIZE);
+
+			++num_chunks;
+			num_uniform += block_data->is_uniform();
+		});
+	});
+
+	// The world generates every chunk in its grid up front, which covers the cube and the
+	// neighbours on its boundary. Meshing runs on this thread so that it is timed on its own.
+	World world{radius};
+	auto chunk_update = std::make_unique<ChunkUpdate>(nullptr, 0, 0, 0, 0, false);
+
+	int num_draw_calls = 0;
+	std::size_t num_triangles = 0;
+	std::size_t mesh_bytes = 0;
+
+	auto mesh = time_milliseconds([&for_each_chunk, &world, &chunk_update, &num_draw_calls, &num_triangles, &mesh_bytes]()
+	{
+		for_each_chunk([&world, &chunk_update, &num_draw_calls, &num_triangles, &mesh_bytes](int x, int y, int z)
+		{
+			chunk_update->reset(world.get_chunk_block_data(x, y, z), 0, x, y, z, false);
+			chunk_update->run();
+
+			// Chunks with an empty mesh aren't drawn
+			num_draw_calls += chunk_update->get_num_indices() > 0;
+			num_triangles += chunk_update->get_num_indices() / 3;
+			mesh_bytes += chunk_update->get_mesh_size();
+		});
+	});
+
+	out << "Chunk pipeline, " << 2 * RADIUS_BLOCKS << "^3 blocks on one thread\n";
+	out << "chunks\tuniform\tgenerate ms\tmesh ms\tgenerate us/chunk\tmesh us/chunk\tdraw calls\ttriangles\tmesh MB\n";
+	out << num_chunks << '\t' << num_uniform << '\t' << generate << '\t' << mesh << '\t' << generate * 1000.0 / num_chunks << '\t' << mesh * 1000.0 / num_chunks
+		<< '\t' << num_draw_calls << '\t' << num_triangles << '\t' << mesh_bytes / (1024.0 * 1024.0) << "\n\n";
+}
+
+void Benchmark::run_block_queries(std::ostream& out)
+{
+	// A cube of blocks around spawn, well inside the loaded chunks at any chunk size
+	const int HALF_SIZE = 64;
+	const int NUM_RAYS = 1 << 14;
+	const int RAY_LENGTH = 48;
+
+	World world{HALF_SIZE / WorldConstants::CHUNK_SIZE + 1};
+
+	auto spawn = WorldGen::get_spawn_pos();
+	int spawn_x = static_cast<int>(std::floor(spawn.x));
+	int spawn_y = static_cast<int>(std::floor(spawn.y));
+	int spawn_z = static_cast<int>(std::floor(spawn.z));
+
+	// Every block of the cube in turn, like a collision check over a bounding box
+	std::size_t raw_solid = 0;
+	std::size_t accessor_solid = 0;
+
+	auto raw_scan = time_milliseconds([&world, &raw_solid, spawn_x, spawn_y, spawn_z]()
+	{
+		for (int x = spawn_x - HALF_SIZE; x < spawn_x + HALF_SIZE; ++x)
+		{
+			for (int z = spawn_z - HALF_SIZE; z < spawn_z + HALF_SIZE; ++z)
+			{
+				for (int y = spawn_y - HALF_SIZE; y < spawn_y + HALF_SIZE; ++y)
+				{
+					raw_solid += world.is_block_at(x, y, z);
+				}
+			}
+		}
+	});
+
+	auto accessor_scan = time_milliseconds([&world, &accessor_solid, spawn_x, spawn_y, spawn_z]()
+	{
+		BlockAccessor blocks{world, spawn_x, spawn_y, spawn_z};
+
+		for (int x = spawn_x - HALF_SIZE; x < spawn_x + HALF_SIZE; ++x)
+		{
+			for (int z = spawn_z - HALF_SIZE; z < spawn_z + HALF_SIZE; ++z)
+			{
+				for (int y = spawn_y - HALF_SIZE; y < spawn_y + HALF_SIZE; ++y)
+				{
+					blocks.move_to(x, y, z);
+					accessor_solid += blocks.is_block_at();
+				}
+			}
+		}
+	});
+
+	// Rays stepping one block at a time from random points in random axis directions, like a
+	// raycast. The accessor moves relative to where it is.
+	std::mt19937 random{1};
+	std::uniform_int_distribution<int> coord{-HALF_SIZE + RAY_LENGTH, HALF_SIZE - RAY_LENGTH};
+	std::uniform_int_distribution<int> step{-1, 1};
+	std::vector<std::array<int, 6>> rays(NUM_RAYS);
+
+	for (auto& ray : rays)
+	{
+		ray = {spawn_x + coord(random), spawn_y + coord(random), spawn_z + coord(random), step(random), step(random), step(random)};
+	}
+
+	auto raw_rays = time_milliseconds([&world, &rays, &raw_solid]()
+	{
+		for (auto& ray : rays)
+		{
+			for (int i = 0; i < RAY_LENGTH; ++i)
+			{
+				raw_solid += world.is_block_at(ray[0] + ray[3] * i, ray[1] + ray[4] * i, ray[2] + ray[5] * i);
+			}
+		}
+	});
+
+	auto accessor_rays = time_milliseconds([&world, &rays, &accessor_solid]()
+	{
+		for (auto& ray : rays)
+		{
+			BlockAccessor blocks{world, ray[0], ray[1], ray[2]};
+
+			for (int i = 0; i < RAY_LENGTH; ++i)
+			{
+				accessor_solid += blocks.is_block_at();
+				blocks.step(ray[3], ray[4], ray[5]);
+			}
+		}
+	});
+
+	if (raw_solid != accessor_solid)
+	{
+		throw BenchmarkException("World and block accessor queries disagree");
+	}
+
+	auto nanoseconds = [](double milliseconds, double queries) { return milliseconds * 1000000.0 / queries; };
+	double scan_queries = 8.0 * HALF_SIZE * HALF_SIZE * HALF_SIZE;
+	double ray_queries = static_cast<double>(NUM_RAYS) * RAY_LENGTH;
+
+	out << "Block queries, nanoseconds per query\n";
+	out << "world scan\taccessor scan\tworld rays\taccessor rays\n";
+	out << nanoseconds(raw_scan, scan_queries) << '\t' << nanoseconds(accessor_scan, scan_queries) << '\t'
+		<< nanoseconds(raw_rays, ray_queries) << '\t' << nanoseconds(accessor_rays, ray_queries) << "\n\n";
+}
+
+void Benchmark::run_state_scans(std::ostream& out)
+{
+	const int NUM_SCANS = 20;
+
+	out << "Chunk state scans, microseconds per scan with 1 in 8 chunks filled\n";
+	out << "radius\tchunks\ttable scan\tvisit every chunk\n";
+
+	for (int radius : {8, 16, 32})
+	{
+		EpochManager epochs;
+		ChunkGrid grid{radius, epochs};
+
+		// About as many chunks as have a mesh in practice
+		std::mt19937 random{1};
+		int num_chunks = 0;
+		int num_filled = 0;
+
+		for (int x = -radius; x <= radius; ++x)
+		{
+			for (int y = -radius; y <= radius; ++y)
+			{
+				for (int z = -radius; z <= radius; ++z)
+				{
+					auto chunk = std::make_unique<Chunk>(x, y, z);
+
+					if (random() % 8 == 0)
+					{
+						chunk->set_generated();
+						++num_filled;
+					}
+
+					grid.set_slot(x, y, z, std::move(chunk));
+					++num_chunks;
+				}
+			}
+		}
+
+		int table_found = 0;
+		int visit_found = 0;
+
+		auto table_scan = time_milliseconds([&grid, &table_found]()
+		{
+			for (int i = 0; i < NUM_SCANS; ++i)
+			{
+				grid.for_each([&table_found](Chunk*)
+				{
+					++table_found;
+					return true;
+				}, Chunk::FILLED);
+			}
+		});
+
+		auto visit_scan = time_milliseconds([&grid, &visit_found]()
+		{
+			for (int i = 0; i < NUM_SCANS; ++i)
+			{
+				grid.for_each([&visit_found](Chunk* chunk)
+				{
+					visit_found += chunk->filled();
+					return true;
+				});
+			}
+		});
+
+		if (table_found != num_filled * NUM_SCANS || visit_found != table_found)
+		{
+			throw BenchmarkException("Chunk state scans disagree");
+		}
+
+		out << radius << '\t' << num_chunks << '\t' << table_scan * 1000.0 / NUM_SCANS << '\t' << visit_scan * 1000.0 / NUM_SCANS << '\n';
+	}
+
+	out << '\n';
+}
+
+void Benchmark::run_resizes(std::ostream& out)
+{
+	// The world generates every chunk within the render distance up front. Resizes don't load
+	// anything until the next update, so shrinking drops chunks and growing doesn't add any.
+	const int RENDER_DISTANCE = 6;
+
+	World world{RENDER_DISTANCE};
+
+	int center_x;
+	int center_y;
+	int center_z;
+	get_spawn_chunk(center_x, center_y, center_z);
+
+	int loaded_radius = RENDER_DISTANCE + World::GENERATION_MARGIN;
+	int render_distance = RENDER_DISTANCE;
+
+	out << "Render distance changes on a loaded world, milliseconds\n";
+	out << "from\tto\ttime\tunloaded chunks\n";
+
+	for (int new_render_distance : {3, 1, 4, 2})
+	{
+		auto cached = world.get_chunk_cache().get_size();
+
+		auto resize = time_milliseconds([&world, new_render_distance]()
+		{
+			world.set_render_distance(new_render_distance);
+		});
+
+		// Chunks beyond the new grid go through the world's unload path, which caches them
+		int grid_radius = new_render_distance + World::UNLOAD_DISTANCE_MARGIN;
+		std::size_t unloaded = 0;
+
+		if (grid_radius < loaded_radius)
+		{
+			auto cube = [](int radius) { return static_cast<std::size_t>((2 * radius + 1) * (2 * radius + 1) * (2 * radius + 1)); };
+			unloaded = cube(loaded_radius) - cube(grid_radius);
+			loaded_radius = grid_radius;
+		}
+
+		if (world.get_chunk_cache().get_size() != std::min(cached + unloaded, world.get_chunk_cache().get_capacity()))
+		{
+			throw BenchmarkException("Chunks dropped by a resize weren't unloaded through the world");
+		}
+
+		// Chunks near the center are kept by every resize
+		for (int x = center_x - 1; x <= center_x + 1; ++x)
+		{
+			for (int y = center_y - 1; y <= center_y + 1; ++y)
+			{
+				for (int z = center_z - 1; z <= center_z + 1; ++z)
+				{
+					if (!world.get_chunk_block_data(x, y, z))
+					{
+						throw BenchmarkException("A chunk near the center was lost by a resize");
+					}
+				}
+			}
+		}
+
+		out << render_distance << '\t' << new_render_distance << '\t' << resize << '\t' << unloaded << '\n';
+		render_distance = new_render_distance;
+	}
+
+	out << '\n';
+}
+
+void Benchmark::run_time_to_visible(std::ostream& out)
+{
+	const int RENDER_DISTANCE = 6;
+	const float TELEPORT_DISTANCE = 4096.0f;
+	const auto FRAME_DURATION = std::chrono::nanoseconds{std::nano::den / 120};
+	const auto TIMEOUT = std::chrono::seconds{30};
+
+	struct TrackedChunk
+	{
+		int x;
+		int y;
+		int z;
+		bool in_view;
+		bool ready;
+		double milliseconds;
+	};
+
+	World world{RENDER_DISTANCE};
+
+	// Far enough from spawn that nothing is loaded, looking along +x
+	auto center = WorldGen::get_spawn_pos() + glm::vec3(TELEPORT_DISTANCE, 0.0f, 0.0f);
+	auto view_projection = m_rendering_engine.get_projection_matrix() * glm::lookAt(center, center + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum{view_projection};
+
+	int center_x = Chunk::get_chunk_coord(static_cast<int>(std::floor(center.x)));
+	int center_y = Chunk::get_chunk_coord(static_cast<int>(std::floor(center.y)));
+	int center_z = Chunk::get_chunk_coord(static_cast<int>(std::floor(center.z)));
+
+	std::vector<TrackedChunk> tracked;
+	const float chunk_size = static_cast<float>(WorldConstants::CHUNK_SIZE);
+
+	for (int x = center_x - RENDER_DISTANCE; x <= center_x + RENDER_DISTANCE; ++x)
+	{
+		for (int y = center_y - RENDER_DISTANCE; y <= center_y + RENDER_DISTANCE; ++y)
+		{
+			for (int z = center_z - RENDER_DISTANCE; z <= center_z + RENDER_DISTANCE; ++z)
+			{
+				glm::vec3 low(x * chunk_size, y * chunk_size, z * chunk_size);
+				tracked.push_back({x, y, z, frustum.intersects({low, low + chunk_size}), false, 0.0});
+			}
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto next_frame = start;
+	auto remaining = tracked.size();
+	int num_frames = 0;
+
+	while (remaining > 0 && std::chrono::steady_clock::now() - start < TIMEOUT)
+	{
+		m_window.update(false);
+		world.update(center, glm::vec3(0.0f), view_projection);
+		++num_frames;
+
+		auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		for (auto& chunk : tracked)
+		{
+			if (chunk.ready)
+			{
+				continue;
+			}
+
+			auto loaded = world.get_chunk(chunk.x, chunk.y, chunk.z);
+
+			if (loaded && loaded->get_stage() == Chunk::READY)
+			{
+				chunk.ready = true;
+				chunk.milliseconds = elapsed;
+				--remaining;
+			}
+		}
+
+		next_frame += FRAME_DURATION;
+		std::this_thread::sleep_until(next_frame);
+	}
+
+	out << "Time to visible after a teleport, milliseconds, render distance " << RENDER_DISTANCE << ", " << num_frames << " frames\n";
+	out << "chunks\tcount\tmedian\t90%\tmax\tnot ready\n";
+
+	for (bool in_view : {true, false})
+	{
+		std::vector<double> times;
+		int not_ready = 0;
+
+		for (auto& chunk : tracked)
+		{
+			if (chunk.in_view != in_view)
+			{
+				continue;
+			}
+
+			if (chunk.ready)
+			{
+				times.push_back(chunk.milliseconds);
+			}
+			else
+			{
+				++not_ready;
+			}
+		}
+
+		auto count = times.size() + not_ready;
+		auto median = get_percentile(times, 0.5);
+		auto percentile_90 = get_percentile(times, 0.9);
+		auto max = get_percentile(times, 1.0);
+
+		out << (in_view ? "in view" : "out of view") << '\t' << count << '\t' << median << '\t' << percentile_90 << '\t' << max << '\t' << not_ready << '\n';
+	}
+
+	out << '\n';
+}
+
+void Benchmark::run_flights(std::ostream& out)
+{
+	const int RENDER_DISTANCE = 4;
+	const auto FRAME_DURATION = std::chrono::nanoseconds{std::nano::den / 120};
+	const int NUM_FRAMES = 120 * 8;
+
+	out << "Flights along +x, " << NUM_FRAMES / 120 << " seconds at render distance " << RENDER_DISTANCE << '\n';
+	out << "speed\tprefetch\tissued\thits\tlate\twasted\thit rate\tholes\tskipped\taborted\tdiscarded\n";
+
+	for (float speed : {10.0f, 40.0f})
+	{
+		for (bool prefetch : {false, true})
+		{
+			World world{RENDER_DISTANCE};
+
+			// Prefetching follows the velocity passed to the world, so passing none turns it off
+			glm::vec3 velocity(speed, 0.0f, 0.0f);
+			auto position = WorldGen::get_spawn_pos();
+			auto seconds = std::chrono::duration<float>(FRAME_DURATION).count();
+			auto next_frame = std::chrono::steady_clock::now();
+
+			for (int i = 0; i < NUM_FRAMES; ++i)
+			{
+				auto view_projection = m_rendering_engine.get_projection_matrix() * glm::lookAt(position, position + velocity, glm::vec3(0.0f, 1.0f, 0.0f));
+
+				m_window.update(false);
+				world.update(position, prefetch ? velocity : glm::vec3(0.0f), view_projection);
+				position += velocity * seconds;
+
+				next_frame += FRAME_DURATION;
+				std::this_thread::sleep_until(next_frame);
+			}
+
+			auto& stats = world.get_prefetch_stats();
+			auto cancellations = world.get_cancellation_stats();
+			auto hit_rate = stats.issued > 0 ? static_cast<double>(stats.hits) / stats.issued : 0.0;
+
+			out << speed << '\t' << (prefetch ? "on" : "off") << '\t' << stats.issued << '\t' << stats.hits << '\t' << stats.late << '\t' << stats.wasted << '\t'
+				<< hit_rate << '\t' << stats.holes << '\t' << cancellations.skipped << '\t' << cancellations.aborted << '\t' << cancellations.discarded << '\n';
+		}
+	}
+
+	out << '\n';
+}
\ No newline at end of file
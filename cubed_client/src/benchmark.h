@@ -0,0 +1,57 @@
+#ifndef CUBED_BENCHMARK_H
+#define CUBED_BENCHMARK_H
+
+#include "input_manager.h"
+#include "rendering_engine.h"
+#include "window.h"
+#include <ostream>
+
+// Timings of the chunk pipeline, run instead of the game when the executable is started with
+// -benchmark. Chunk size and block layout are compile time options, so comparing them takes a
+// build of each. The report starts with the configuration it was built with, so that reports
+// from several builds can be put side by side.
+class Benchmark
+{
+public:
+	Benchmark();
+
+	void run(std::ostream& out);
+
+private:
+	// Chunk lookups in the toroidal chunk grid against the nested hash maps it replaced
+	void run_chunk_lookups(std::ostream& out);
+
+	// Generation and meshing time and the resulting draw calls for the same volume of terrain
+	// at whatever chunk size and block layout the build uses
+	void run_chunk_pipeline(std::ostream& out);
+
+	// Block queries through World::get_block_type against a BlockAccessor
+	void run_block_queries(std::ostream& out);
+
+	// Passes over every chunk that filter on the grid's state table against ones that visit
+	// every chunk, and render distance changes on a populated world
+	void run_state_scans(std::ostream& out);
+	void run_resizes(std::ostream& out);
+
+	// How long chunks in and out of view take to get their mesh after a teleport, with the
+	// world updated at the game's frame rate
+	void run_time_to_visible(std::ostream& out);
+
+	// Straight flights at a few speeds with and without prefetching along the velocity
+	void run_flights(std::ostream& out);
+
+	// Only there for the GL context that mesh uploads need
+	InputManager m_input_manager;
+	Window m_window;
+	RenderingEngine m_rendering_engine;
+};
+
+#include "cubed_exception.h"
+
+class BenchmarkException : public CubedException
+{
+public:
+	BenchmarkException(std::string message) : CubedException(std::move(message)) { }
+};
+
+#endif
\ No newline at end of file
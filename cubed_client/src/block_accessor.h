@@ -0,0 +1,83 @@
+#ifndef CUBED_BLOCK_ACCESSOR_H
+#define CUBED_BLOCK_ACCESSOR_H
+
+#include "block_type.h"
+#include "chunk.h"
+#include "world.h"
+#include "world_constants.h"
+#include <cstdint>
+
+// Cursor for reading blocks from the world that remembers the chunk it is in. Moves that stay
+// inside the same chunk, which collision checks and raycasts nearly always do, skip the chunk
+// lookup entirely. The cached chunk isn't tracked, so an accessor must not be kept across a
+// World::update. Main thread only.
+class BlockAccessor
+{
+public:
+	BlockAccessor(const World& world, int block_x, int block_y, int block_z) :
+		m_world(world),
+		m_chunk{nullptr},
+		m_origin_x{0},
+		m_origin_y{0},
+		m_origin_z{0}
+	{
+		find_chunk(block_x, block_y, block_z);
+	}
+
+	void move_to(int block_x, int block_y, int block_z)
+	{
+		m_local_x = block_x - m_origin_x;
+		m_local_y = block_y - m_origin_y;
+		m_local_z = block_z - m_origin_z;
+
+		// Negative coordinates wrap to large unsigned values, so one comparison per axis
+		// checks both bounds
+		if (static_cast<unsigned int>(m_local_x) >= WorldConstants::CHUNK_SIZE ||
+			static_cast<unsigned int>(m_local_y) >= WorldConstants::CHUNK_SIZE ||
+			static_cast<unsigned int>(m_local_z) >= WorldConstants::CHUNK_SIZE)
+		{
+			find_chunk(block_x, block_y, block_z);
+		}
+	}
+
+	void step(int offset_x, int offset_y, int offset_z) { move_to(get_x() + offset_x, get_y() + offset_y, get_z() + offset_z); }
+
+	BlockType get_block_type() const { return m_chunk ? m_chunk->get_block_type(m_local_x, m_local_y, m_local_z) : BLOCK_AIR; }
+	bool is_block_at() const { return get_block_type() != BLOCK_AIR; }
+
+	// Solid mask of the current column within the current chunk. Bit y is set if the block at
+	// get_chunk_y() * CHUNK_SIZE + y is solid.
+	std::uint64_t get_solid_column() const { return m_chunk ? m_chunk->get_solid_column(m_local_x, m_local_z) : 0; }
+
+	int get_x() const { return m_origin_x + m_local_x; }
+	int get_y() const { return m_origin_y + m_local_y; }
+	int get_z() const { return m_origin_z + m_local_z; }
+	int get_chunk_y() const { return m_origin_y / WorldConstants::CHUNK_SIZE; }
+
+private:
+	void find_chunk(int block_x, int block_y, int block_z)
+	{
+		int chunk_x = Chunk::get_chunk_coord(block_x);
+		int chunk_y = Chunk::get_chunk_coord(block_y);
+		int chunk_z = Chunk::get_chunk_coord(block_z);
+
+		m_chunk = m_world.get_chunk(chunk_x, chunk_y, chunk_z);
+		m_origin_x = chunk_x * WorldConstants::CHUNK_SIZE;
+		m_origin_y = chunk_y * WorldConstants::CHUNK_SIZE;
+		m_origin_z = chunk_z * WorldConstants::CHUNK_SIZE;
+		m_local_x = block_x - m_origin_x;
+		m_local_y = block_y - m_origin_y;
+		m_local_z = block_z - m_origin_z;
+	}
+
+	const World& m_world;
+	Chunk* m_chunk;
+	int m_origin_x;
+	int m_origin_y;
+	int m_origin_z;
+	int m_local_x;
+	int m_local_y;
+	int m_local_z;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,348 @@
+#include "block_data.h"
+#include "block_info.h"
+#include "lz4.h"
+#include <algorithm>
+
+const std::uint64_t BlockData::FULL_COLUMN;
+std::atomic<std::size_t> BlockData::s_compressed_bytes{0};
+std::atomic<unsigned long long> BlockData::s_decompressions{0};
+
+namespace
+{
+	// Inverse of the bit spreading in Chunk::get_block_index
+	int compact_bits(int value)
+	{
+		value &= 0x09249249;
+		value = (value | (value >> 2)) & 0x030c30c3;
+		value = (value | (value >> 4)) & 0x0300f00f;
+		value = (value | (value >> 8)) & 0x000000ff;
+		return value;
+	}
+
+	// Maps a block index to its bit in the column ordered masks, which is
+	// (x * CHUNK_SIZE + z) * CHUNK_SIZE + y whatever the block layout is.
+	int get_mask_bit(int index)
+	{
+		const int size = WorldConstants::CHUNK_SIZE;
+
+		switch (WorldConstants::BLOCK_LAYOUT)
+		{
+		case BlockLayout::Y_MAJOR:
+			return ((index / size % size) * size + index % size) * size + index / (size * size);
+		case BlockLayout::MORTON:
+			return (compact_bits(index >> 2) * size + compact_bits(index >> 1)) * size + compact_bits(index);
+		default:
+			return index;
+		}
+	}
+
+	std::array<bool, NUM_BLOCK_TYPES> get_opaque_types()
+	{
+		const BlockInfo block_info;
+		std::array<bool, NUM_BLOCK_TYPES> opaque;
+
+		for (int i = 0; i < NUM_BLOCK_TYPES; ++i)
+		{
+			opaque[i] = block_info.get_properties(static_cast<BlockType>(i)).render;
+		}
+
+		return opaque;
+	}
+}
+
+const std::array<bool, NUM_BLOCK_TYPES> BlockData::s_opaque = get_opaque_types();
+
+BlockData::BlockData() :
+	m_palette{{BLOCK_AIR}},
+	m_palette_size{1},
+	m_bits_per_block{0},
+	m_index_mask{0}
+{
+}
+
+BlockData::BlockData(const BlockData& other) :
+	m_palette(other.m_palette),
+	m_palette_size{other.m_palette_size},
+	m_bits_per_block{other.m_bits_per_block},
+	m_index_mask{other.m_index_mask},
+	m_compressed{other.m_compressed}
+{
+	get_buffer_pool().assign(m_indices, other.m_indices);
+	get_buffer_pool().assign(m_solid, other.m_solid);
+	get_buffer_pool().assign(m_opaque, other.m_opaque);
+
+	s_compressed_bytes += m_compressed.size();
+}
+
+BlockData::~BlockData()
+{
+	s_compressed_bytes -= m_compressed.size();
+
+	get_buffer_pool().release(m_indices);
+	get_buffer_pool().release(m_solid);
+	get_buffer_pool().release(m_opaque);
+}
+
+const std::shared_ptr<const BlockData>& BlockData::get_empty()
+{
+	// The pools are created first so that they outlive the empty block data at exit
+	get_buffer_pool();
+
+	static const std::shared_ptr<const BlockData> empty = create();
+	return empty;
+}
+
+ObjectPool& BlockData::get_pool()
+{
+	static ObjectPool pool;
+	return pool;
+}
+
+WordBufferPool& BlockData::get_buffer_pool()
+{
+	static WordBufferPool pool{MAX_POOLED_BUFFERS};
+	return pool;
+}
+
+void BlockData::set(int index, BlockType type)
+{
+	decompress();
+
+	auto palette_index = get_palette_index(type);
+
+	if (palette_index < 0)
+	{
+		palette_index = static_cast<int>(m_palette_size);
+		m_palette[m_palette_size++] = type;
+
+		auto bits_per_block = get_bits_for_palette_size(m_palette_size);
+
+		if (bits_per_block != m_bits_per_block)
+		{
+			set_bits_per_block(bits_per_block);
+		}
+	}
+
+	if (m_bits_per_block > 0)
+	{
+		set_index(index, static_cast<std::uint64_t>(palette_index));
+		set_mask_bits(index, type);
+	}
+}
+
+void BlockData::fill(BlockType type)
+{
+	clear_compressed();
+	m_palette[0] = type;
+	m_palette_size = 1;
+	get_buffer_pool().release(m_indices);
+	m_bits_per_block = 0;
+	m_index_mask = 0;
+	get_buffer_pool().release(m_solid);
+	get_buffer_pool().release(m_opaque);
+}
+
+BlockData::BlockArray& BlockData::get_scratch_array()
+{
+	thread_local std::unique_ptr<BlockArray> blocks{new BlockArray};
+	return *blocks;
+}
+
+void BlockData::get_all(BlockArray& blocks) const
+{
+	if (m_bits_per_block == 0)
+	{
+		blocks.fill(m_palette[0]);
+		return;
+	}
+
+	if (is_compressed())
+	{
+		auto& indices = get_scratch_indices(WorldConstants::CHUNK_NUM_BLOCKS * m_bits_per_block / 64);
+		decompress_indices(indices);
+		unpack(indices, blocks);
+		return;
+	}
+
+	unpack(m_indices, blocks);
+}
+
+void BlockData::set_all(const BlockArray& blocks)
+{
+	clear_compressed();
+	m_palette_size = 0;
+
+	for (auto type : blocks)
+	{
+		if (get_palette_index(type) < 0)
+		{
+			m_palette[m_palette_size++] = type;
+		}
+	}
+
+	m_bits_per_block = get_bits_for_palette_size(m_palette_size);
+	m_index_mask = (std::uint64_t{1} << m_bits_per_block) - 1;
+	get_buffer_pool().assign(m_indices, WorldConstants::CHUNK_NUM_BLOCKS * m_bits_per_block / 64, 0);
+
+	if (m_bits_per_block == 0)
+	{
+		get_buffer_pool().release(m_solid);
+		get_buffer_pool().release(m_opaque);
+		return;
+	}
+
+	get_buffer_pool().assign(m_solid, MASK_WORDS, 0);
+	get_buffer_pool().assign(m_opaque, MASK_WORDS, 0);
+
+	for (int i = 0; i < WorldConstants::CHUNK_NUM_BLOCKS; ++i)
+	{
+		set_index(i, static_cast<std::uint64_t>(get_palette_index(blocks[i])));
+		set_mask_bits(i, blocks[i]);
+	}
+}
+
+void BlockData::compress()
+{
+	if (m_bits_per_block == 0 || is_compressed())
+	{
+		return;
+	}
+
+	m_compressed = LZ4::compress(reinterpret_cast<const std::uint8_t*>(m_indices.data()), m_indices.size() * sizeof(m_indices[0]));
+	get_buffer_pool().release(m_indices);
+
+	s_compressed_bytes += m_compressed.size();
+}
+
+void BlockData::decompress()
+{
+	if (!is_compressed())
+	{
+		return;
+	}
+
+	get_buffer_pool().assign(m_indices, WorldConstants::CHUNK_NUM_BLOCKS * m_bits_per_block / 64, 0);
+	decompress_indices(m_indices);
+	clear_compressed();
+}
+
+void BlockData::set_mask_bits(int index, BlockType type)
+{
+	auto bit = get_mask_bit(index);
+	auto mask = std::uint64_t{1} << (bit & 63);
+
+	m_solid[bit >> 6] = is_solid(type) ? (m_solid[bit >> 6] | mask) : (m_solid[bit >> 6] & ~mask);
+	m_opaque[bit >> 6] = is_opaque(type) ? (m_opaque[bit >> 6] | mask) : (m_opaque[bit >> 6] & ~mask);
+}
+
+BlockType BlockData::get_compressed(int index) const
+{
+	auto& indices = get_scratch_indices(WorldConstants::CHUNK_NUM_BLOCKS * m_bits_per_block / 64);
+	decompress_indices(indices);
+
+	auto bit = index * m_bits_per_block;
+	return m_palette[(indices[bit >> 6] >> (bit & 63)) & m_index_mask];
+}
+
+void BlockData::decompress_indices(WordBufferPool::Buffer& indices) const
+{
+	if (!LZ4::decompress(m_compressed.data(), m_compressed.size(), reinterpret_cast<std::uint8_t*>(indices.data()), indices.size() * sizeof(indices[0])))
+	{
+		throw BlockDataException("Corrupt compressed block data");
+	}
+
+	++s_decompressions;
+}
+
+void BlockData::unpack(const WordBufferPool::Buffer& indices, BlockArray& blocks) const
+{
+	auto blocks_per_word = 64 / m_bits_per_block;
+	int index = 0;
+
+	for (auto word : indices)
+	{
+		for (int i = 0; i < blocks_per_word; ++i)
+		{
+			blocks[index++] = m_palette[word & m_index_mask];
+			word >>= m_bits_per_block;
+		}
+	}
+}
+
+WordBufferPool::Buffer& BlockData::get_scratch_indices(std::size_t size)
+{
+	// Sized for the widest indices up front, so it never grows
+	thread_local WordBufferPool::Buffer indices(WorldConstants::CHUNK_NUM_BLOCKS * 16 / 64);
+	indices.resize(size);
+	return indices;
+}
+
+void BlockData::clear_compressed()
+{
+	s_compressed_bytes -= m_compressed.size();
+	m_compressed.clear();
+	m_compressed.shrink_to_fit();
+}
+
+int BlockData::get_palette_index(BlockType type) const
+{
+	for (std::size_t i = 0; i < m_palette_size; ++i)
+	{
+		if (m_palette[i] == type)
+		{
+			return static_cast<int>(i);
+		}
+	}
+
+	return -1;
+}
+
+void BlockData::set_index(int index, std::uint64_t palette_index)
+{
+	auto bit = index * m_bits_per_block;
+	auto& word = m_indices[bit >> 6];
+	auto shift = bit & 63;
+
+	word = (word & ~(m_index_mask << shift)) | (palette_index << shift);
+}
+
+void BlockData::set_bits_per_block(int bits_per_block)
+{
+	auto old_bits_per_block = m_bits_per_block;
+	auto old_index_mask = m_index_mask;
+	WordBufferPool::Buffer old_indices;
+	old_indices.swap(m_indices);
+
+	m_bits_per_block = bits_per_block;
+	m_index_mask = (std::uint64_t{1} << bits_per_block) - 1;
+	get_buffer_pool().assign(m_indices, WorldConstants::CHUNK_NUM_BLOCKS * bits_per_block / 64, 0);
+
+	// A chunk without an index array is made up entirely of the first palette entry, so the new
+	// array is already correct when it is zeroed.
+	if (old_bits_per_block == 0)
+	{
+		get_buffer_pool().assign(m_solid, MASK_WORDS, is_solid(m_palette[0]) ? ~std::uint64_t{0} : 0);
+		get_buffer_pool().assign(m_opaque, MASK_WORDS, is_opaque(m_palette[0]) ? ~std::uint64_t{0} : 0);
+		return;
+	}
+
+	for (int i = 0; i < WorldConstants::CHUNK_NUM_BLOCKS; ++i)
+	{
+		auto bit = i * old_bits_per_block;
+		set_index(i, (old_indices[bit >> 6] >> (bit & 63)) & old_index_mask);
+	}
+
+	get_buffer_pool().release(old_indices);
+}
+
+int BlockData::get_bits_for_palette_size(std::size_t palette_size)
+{
+	int bits_per_block = 0;
+
+	while ((std::size_t{1} << bits_per_block) < palette_size)
+	{
+		bits_per_block = bits_per_block == 0 ? 1 : bits_per_block * 2;
+	}
+
+	return bits_per_block;
+}
\ No newline at end of file
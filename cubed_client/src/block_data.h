@@ -0,0 +1,173 @@
+#ifndef CUBED_BLOCK_DATA_H
+#define CUBED_BLOCK_DATA_H
+
+#include "block_type.h"
+#include "object_pool.h"
+#include "world_constants.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Block storage for a single chunk. Each block is stored as an index into a per chunk palette of
+// block types, packed into 64 bit words. The number of bits per index grows on demand
+// (0, 1, 2, 4, 8 or 16) as new block types are written, so a chunk made of one or two block
+// types only costs a few hundred bytes.
+//
+// The palette is stored inline and the index and mask arrays are recycled through a buffer pool,
+// so once the pool has warmed up, creating and destroying block data doesn't go to the system
+// allocator. Only the LZ4 compressed copies of cold chunks are allocated each time.
+//
+// Chunks that haven't been touched in a while can additionally have their index array LZ4
+// compressed. Compressed data can still be read in bulk with get_all, but it has to be
+// decompressed before it is modified, and single block reads are slow until it is.
+//
+// Alongside the blocks, a solid (not air) mask and an opaque (rendered) mask are kept up to date
+// by every write. Each holds one CHUNK_SIZE bit column per x and z, with bit y set for each
+// matching block, so a whole column can be tested with a single word operation. The masks are
+// never compressed, so querying them doesn't decompress the blocks.
+class BlockData
+{
+public:
+	typedef std::array<BlockType, WorldConstants::CHUNK_NUM_BLOCKS> BlockArray;
+
+	static const std::uint64_t FULL_COLUMN = WorldConstants::CHUNK_SIZE == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << (WorldConstants::CHUNK_SIZE % 64)) - 1;
+
+	BlockData();
+	BlockData(const BlockData& other);
+	BlockData& operator=(const BlockData&) = delete;
+	~BlockData();
+
+	// Chunks churn through block data constantly, so it is allocated together with its
+	// shared_ptr control block from a pool
+	template<typename... Args>
+	static std::shared_ptr<BlockData> create(Args&&... args) { return std::allocate_shared<BlockData>(PoolAllocator<BlockData>(get_pool()), std::forward<Args>(args)...); }
+
+	// Shared by every chunk that hasn't been generated yet
+	static const std::shared_ptr<const BlockData>& get_empty();
+
+	static ObjectPool& get_pool();
+	static WordBufferPool& get_buffer_pool();
+
+	BlockType get(int index) const
+	{
+		if (m_bits_per_block == 0)
+		{
+			return m_palette[0];
+		}
+
+		if (is_compressed())
+		{
+			return get_compressed(index);
+		}
+
+		auto bit = index * m_bits_per_block;
+		return m_palette[(m_indices[bit >> 6] >> (bit & 63)) & m_index_mask];
+	}
+
+	void set(int index, BlockType type);
+
+	// Makes every block the given type without allocating an index array. The array is only
+	// materialised by the first set() of a different type.
+	void fill(BlockType type);
+
+	bool is_uniform() const { return m_bits_per_block == 0; }
+	BlockType get_uniform_type() const { return m_palette[0]; }
+
+	// Bulk access. set_all rebuilds the palette from scratch so it also shrinks the storage
+	// after blocks have been removed.
+	void get_all(BlockArray& blocks) const;
+	void set_all(const BlockArray& blocks);
+
+	// A block array for the calling thread to build or unpack a whole chunk in. Block arrays are
+	// too big for the stack at the larger chunk sizes (see world_constants.h), so they are
+	// allocated once per thread and reused. Only one caller per thread may use it at a time.
+	static BlockArray& get_scratch_array();
+
+	std::uint64_t get_solid_column(int x, int z) const { return is_uniform() ? (is_solid(m_palette[0]) ? FULL_COLUMN : 0) : get_column(m_solid, x, z); }
+	std::uint64_t get_opaque_column(int x, int z) const { return is_uniform() ? (is_opaque(m_palette[0]) ? FULL_COLUMN : 0) : get_column(m_opaque, x, z); }
+
+	static bool is_solid(BlockType type) { return type != BLOCK_AIR; }
+	static bool is_opaque(BlockType type) { return s_opaque[type]; }
+
+	// Index of the lowest set bit. bits must not be zero.
+	static int get_lowest_bit(std::uint64_t bits)
+	{
+		static const int de_bruijn_bits[64] =
+		{
+			0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+			62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+			63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+			46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+		};
+
+		return de_bruijn_bits[((bits & (~bits + 1)) * 0x03f79d71b4cb0a89) >> 58];
+	}
+
+	void compress();
+	void decompress();
+	bool is_compressed() const { return !m_compressed.empty(); }
+
+	// Totals across all block data, for monitoring the cold tier
+	static std::size_t get_total_compressed_bytes() { return s_compressed_bytes; }
+	static unsigned long long get_total_decompressions() { return s_decompressions; }
+
+private:
+	static const int MASK_WORDS = WorldConstants::CHUNK_NUM_BLOCKS / 64;
+
+	static std::uint64_t get_column(const WordBufferPool::Buffer& mask, int x, int z)
+	{
+		auto bit = (x * WorldConstants::CHUNK_SIZE + z) * WorldConstants::CHUNK_SIZE;
+		return (mask[bit >> 6] >> (bit & 63)) & FULL_COLUMN;
+	}
+
+	void set_mask_bits(int index, BlockType type);
+
+	BlockType get_compressed(int index) const;
+	// indices must already be the size of the uncompressed array
+	void decompress_indices(WordBufferPool::Buffer& indices) const;
+	void unpack(const WordBufferPool::Buffer& indices, BlockArray& blocks) const;
+	static WordBufferPool::Buffer& get_scratch_indices(std::size_t size);
+	void clear_compressed();
+
+	int get_palette_index(BlockType type) const;
+	void set_index(int index, std::uint64_t palette_index);
+	void set_bits_per_block(int bits_per_block);
+
+	static int get_bits_for_palette_size(std::size_t palette_size);
+
+	// A palette never holds a type twice, so it can't outgrow the number of types
+	std::array<BlockType, NUM_BLOCK_TYPES> m_palette;
+	std::size_t m_palette_size;
+	WordBufferPool::Buffer m_indices;
+	int m_bits_per_block;
+	std::uint64_t m_index_mask;
+	std::vector<std::uint8_t> m_compressed;
+
+	// Empty while the data is uniform
+	WordBufferPool::Buffer m_solid;
+	WordBufferPool::Buffer m_opaque;
+
+	static const std::array<bool, NUM_BLOCK_TYPES> s_opaque;
+
+	// Freed arrays kept for reuse, per array length
+	static const std::size_t MAX_POOLED_BUFFERS = 1024;
+
+	static std::atomic<std::size_t> s_compressed_bytes;
+	static std::atomic<unsigned long long> s_decompressions;
+};
+
+#include "cubed_exception.h"
+#include <string>
+#include <utility>
+
+class BlockDataException : public CubedException
+{
+public:
+	BlockDataException(std::string message) : CubedException(std::move(message)) { }
+};
+
+#endif
\ No newline at end of file
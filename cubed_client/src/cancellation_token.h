@@ -0,0 +1,28 @@
+#ifndef CUBED_CANCELLATION_TOKEN_H
+#define CUBED_CANCELLATION_TOKEN_H
+
+#include <atomic>
+
+// Lets the owner of some work tell whichever thread is running it that the result is no
+// longer wanted. The work checks the token before it starts and at checkpoints along the way,
+// and gives up at the first one after it has been cancelled.
+class CancellationToken
+{
+public:
+	CancellationToken() :
+		m_cancelled{false}
+	{
+	}
+
+	CancellationToken(const CancellationToken&) = delete;
+	CancellationToken& operator=(const CancellationToken&) = delete;
+
+	void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+	void reset() { m_cancelled.store(false, std::memory_order_relaxed); }
+	bool cancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic_bool m_cancelled;
+};
+
+#endif
\ No newline at end of file
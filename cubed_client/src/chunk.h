@@ -1,81 +1,322 @@
 #ifndef CUBED_CHUNK_H
 #define CUBED_CHUNK_H
 
+#include "block_data.h"
 #include "block_type.h"
+#include "cancellation_token.h"
+#include "dirty_chunk_list.h"
 #include "mesh_pti.h"
+#include "object_pool.h"
 #include "world_constants.h"
-#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <mutex>
-
-struct BlockData
-{
-	std::array<BlockType, WorldConstants::CHUNK_NUM_BLOCKS> blocks;
-	std::mutex mutex;
-};
+#include <utility>
 
 class Chunk
 {
 public:
+	enum State : std::uint8_t
+	{
+		FILLED = 1,
+		UP_TO_DATE = 2,
+		UPDATE_QUEUED = 4,
+		LOW_PRIORITY_UPDATE = 8,
+		HAS_MESH = 16,
+		PREFETCHED = 32
+	};
+
+	// Where the chunk is in its update cycle. Each stage is a combination of the state bits, so
+	// the grid's table can still be filtered on FILLED.
+	//
+	//   EMPTY -> GENERATING -> DIRTY
+	//   DIRTY -> MESHING -> READY or DIRTY
+	//   READY -> DIRTY
+	//
+	// A generated chunk has blocks but no mesh yet, so it is DIRTY. A mesh update finishes as
+	// DIRTY if the chunk was invalidated while it ran, so a change made during an update can't
+	// be lost.
+	enum Stage : std::uint8_t
+	{
+		EMPTY = 0,
+		GENERATING = UPDATE_QUEUED,
+		DIRTY = FILLED,
+		MESHING = FILLED | UPDATE_QUEUED,
+		READY = FILLED | UP_TO_DATE
+	};
+
 	Chunk(int x, int y, int z) :
 		m_x{x},
 		m_y{y},
 		m_z{z},
-		m_filled{false},
-		m_up_to_date{false},
-		m_update_queued{false},
-		m_low_priority_update{true},
-		m_reupdate{false},
+		m_own_state{LOW_PRIORITY_UPDATE},
+		m_state{&m_own_state},
+		m_version{0},
+		m_update_token{nullptr},
+		m_touched{false},
+		m_idle_seconds{0},
+		m_dirty_list{nullptr},
+		m_in_dirty_list{false},
+		m_prev_dirty{nullptr},
+		m_next_dirty{nullptr},
 		m_mesh{false},
-		m_block_data{std::make_shared<BlockData>()}
+		m_block_data{BlockData::get_empty()}
+	{
+	}
+
+	~Chunk() { set_dirty_list(nullptr); }
+
+	Chunk(const Chunk&) = delete;
+	Chunk& operator=(const Chunk&) = delete;
+
+	// Chunks are loaded and unloaded constantly while moving, so they come from a pool
+	static void* operator new(std::size_t size) { return get_pool().allocate(size); }
+	static void operator delete(void* chunk, std::size_t size) { get_pool().deallocate(chunk, size); }
+
+	static ObjectPool& get_pool()
+	{
+		static ObjectPool pool;
+		return pool;
+	}
+
+	template<typename Index>
+	void update_mesh(const VertexPT* vertices, const Index* indices, GLsizei num_vertices, GLsizei num_indices)
 	{
+		m_mesh.set_data(vertices, indices, num_vertices, num_indices);
+		set_state(HAS_MESH, num_indices > 0);
 	}
 
-	void update_mesh(const VertexPT* vertices, const unsigned short* indices, GLsizei num_vertices, GLsizei num_indices) { m_mesh.set_data(vertices, indices, num_vertices, num_indices); }
 	void render() const { m_mesh.render(); }
+	void clear_mesh() { m_mesh.clear_data(); set_state(HAS_MESH, false); invalidate(); }
+
+	auto get_stage() const { return static_cast<Stage>(*m_state & (FILLED | UP_TO_DATE | UPDATE_QUEUED)); }
+	auto filled() const { return (*m_state & FILLED) != 0; }
+	auto update_queued() const { return (*m_state & UPDATE_QUEUED) != 0; }
+
+	// Set until the chunk's first mesh update finishes
+	auto low_priority_update() const { return (*m_state & LOW_PRIORITY_UPDATE) != 0; }
+
+	// Set on chunks generated ahead of the player until they are loaded into the world
+	auto prefetched() const { return (*m_state & PREFETCHED) != 0; }
+	void set_prefetched(bool prefetched) { set_state(PREFETCHED, prefetched); }
+
+	bool needs_update() const { return get_stage() == EMPTY || get_stage() == DIRTY; }
 
-	auto filled() const { return m_filled; }
-	auto up_to_date() const { return m_up_to_date; }
-	auto update_queued() const { return m_update_queued; }
-	auto low_priority_update() const { return m_low_priority_update; }
-	auto reupdate() { auto old = m_reupdate; m_reupdate = false; return old; }
-	void set_filled(bool filled) { m_filled = filled; }
-	void set_up_to_date(bool up_to_date) { m_up_to_date = up_to_date; if (!up_to_date && update_queued()) m_reupdate = true; }
-	void set_update_queued(bool update_queued) { m_update_queued = update_queued; }
-	void set_low_priority_update(bool low_priority_update) { m_low_priority_update = low_priority_update; }
-	void set_reupdate(bool reupdate) { m_reupdate = reupdate; }
+	// For chunks whose blocks were generated without a chunk update
+	void set_generated()
+	{
+		if (get_stage() == EMPTY)
+		{
+			set_stage(DIRTY);
+		}
+	}
+
+	// The chunk must need an update. The token is cancelled if the chunk leaves the world's
+	// grid before the update finishes.
+	void begin_update(CancellationToken* token)
+	{
+		set_stage(get_stage() == EMPTY ? GENERATING : MESHING);
+		m_update_token = token;
+	}
+
+	// Takes the version the update was created from
+	void finish_update(unsigned int version)
+	{
+		if (get_stage() == MESHING)
+		{
+			set_state(LOW_PRIORITY_UPDATE, false);
+		}
+
+		set_stage(get_stage() == MESHING && version == m_version ? READY : DIRTY);
+		m_update_token = nullptr;
+	}
+
+	void cancel_update()
+	{
+		if (m_update_token)
+		{
+			m_update_token->cancel();
+			m_update_token = nullptr;
+		}
+	}
+
+	// Marks the mesh as out of date. Chunks with an update in flight stay in their stage, and
+	// the version change makes the update finish as DIRTY.
+	void invalidate()
+	{
+		++m_version;
+
+		if (get_stage() == READY)
+		{
+			set_stage(DIRTY);
+		}
+	}
+
+	// While the chunk is in the grid its state bits are stored in the grid's metadata table, so
+	// passes over every chunk can stream through the table instead of visiting each chunk.
+	// Passing null moves the bits back into the chunk.
+	void move_state(std::uint8_t* state)
+	{
+		auto bits = *m_state;
+		m_state = state ? state : &m_own_state;
+		*m_state = bits;
+	}
+
+	// Chunks in the world's grid add themselves to its dirty list whenever they need an update.
+	// Chunks outside the grid aren't in any list.
+	void set_dirty_list(DirtyChunkList* dirty_list)
+	{
+		if (m_dirty_list)
+		{
+			m_dirty_list->remove(this);
+		}
+
+		m_dirty_list = dirty_list;
+		mark_dirty();
+	}
+
+	// The version is bumped by every change that invalidates the mesh. A chunk update is
+	// tagged with the version it was created from, so a finished mesh is stale if the
+	// versions no longer match.
+	auto get_version() const { return m_version; }
 
 	auto get_x() const { return m_x; }
 	auto get_y() const { return m_y; }
 	auto get_z() const { return m_z; }
 
-	auto get_block_data() { return m_block_data; }
+	// Block data is never modified once it has been set, since chunk updates hold snapshots of
+	// it and other threads may load it at any time. Writes go to a copy that then replaces it,
+	// so no locking is needed on either side. Only the main thread may call the non-const
+	// functions, and it is the only thread that may read the data without atomic_load.
+	std::shared_ptr<const BlockData> get_block_data() const { return std::atomic_load(&m_block_data); }
+	void set_block_data(std::shared_ptr<const BlockData> block_data) { std::atomic_store(&m_block_data, std::move(block_data)); }
+
+	// Compressed block data is decompressed on the first access
+	BlockType get_block_type(int x, int y, int z)
+	{
+		if (!filled())
+		{
+			return BLOCK_AIR;
+		}
+
+		m_touched = true;
+
+		if (m_block_data->is_compressed())
+		{
+			set_block_data(copy_block_data());
+		}
+
+		return m_block_data->get(get_block_index(x, y, z));
+	}
+
+	// Main thread only, like get_block_type, but doesn't decompress or count as an access
+	std::uint64_t get_solid_column(int x, int z) const { return filled() ? m_block_data->get_solid_column(x, z) : 0; }
 
-	// A lock is only needed for writing. The chunk update thread does write to the block array
-	// but only before m_filled is set to true. Once m_filled is true only the main thread
-	// will write to the block array.
-	auto get_block_type(int x, int y, int z) const { return m_filled ? m_block_data->blocks[get_block_index(x, y, z)] : BLOCK_AIR; }
 	void set_block_type(int x, int y, int z, BlockType type)
 	{
-		auto block_index = get_block_index(x, y, z);
+		auto block_data = copy_block_data();
+		block_data->set(get_block_index(x, y, z), type);
+		set_block_data(std::move(block_data));
+
+		m_touched = true;
+		invalidate();
+	}
+
+	// Applies a list of (block index, type) edits with a single copy and a single invalidation
+	template<typename Edits>
+	void set_block_types(const Edits& edits)
+	{
+		auto block_data = copy_block_data();
 
-		std::lock_guard<decltype(m_block_data->mutex)> lock(m_block_data->mutex);
-		m_block_data->blocks[block_index] = type;
+		for (auto& edit : edits)
+		{
+			block_data->set(edit.first, edit.second);
+		}
+
+		set_block_data(std::move(block_data));
+
+		m_touched = true;
+		invalidate();
 	}
 
-	static int get_block_index(int x, int y, int z) { return x * WorldConstants::CHUNK_SIZE * WorldConstants::CHUNK_SIZE + z * WorldConstants::CHUNK_SIZE + y; }
+	// Called once a second. Returns how many seconds in a row the blocks have gone untouched.
+	int update_idle_seconds()
+	{
+		m_idle_seconds = m_touched ? 0 : m_idle_seconds + 1;
+		m_touched = false;
+		return m_idle_seconds;
+	}
+
+	// Packs coordinates into 21 bit fields for use as a hash map key
+	static std::uint64_t get_coord_key(int x, int y, int z)
+	{
+		return ((static_cast<std::uint64_t>(x) & 0x1fffff) << 42) | ((static_cast<std::uint64_t>(y) & 0x1fffff) << 21) | (static_cast<std::uint64_t>(z) & 0x1fffff);
+	}
+
+	static int get_chunk_coord(int block_coord) { return (block_coord < 0 ? block_coord - WorldConstants::CHUNK_SIZE + 1 : block_coord) / WorldConstants::CHUNK_SIZE; }
+	static int get_block_index(int x, int y, int z)
+	{
+		switch (WorldConstants::BLOCK_LAYOUT)
+		{
+		case BlockLayout::Y_MAJOR:
+			return y * WorldConstants::CHUNK_SIZE * WorldConstants::CHUNK_SIZE + x * WorldConstants::CHUNK_SIZE + z;
+		case BlockLayout::MORTON:
+			return (spread_bits(x) << 2) | (spread_bits(z) << 1) | spread_bits(y);
+		default:
+			return x * WorldConstants::CHUNK_SIZE * WorldConstants::CHUNK_SIZE + z * WorldConstants::CHUNK_SIZE + y;
+		}
+	}
 
 private:
+	friend class DirtyChunkList;
+
+	void set_state(State bit, bool value) { *m_state = value ? (*m_state | bit) : (*m_state & ~bit); }
+
+	void set_stage(Stage stage)
+	{
+		*m_state = (*m_state & ~(FILLED | UP_TO_DATE | UPDATE_QUEUED)) | stage;
+		mark_dirty();
+	}
+
+	void mark_dirty()
+	{
+		if (m_dirty_list && needs_update())
+		{
+			m_dirty_list->push_back(this);
+		}
+	}
+
+	std::shared_ptr<BlockData> copy_block_data() const
+	{
+		auto block_data = BlockData::create(*m_block_data);
+		block_data->decompress();
+		return block_data;
+	}
+
+	// Inserts two zero bits between each of the low 6 bits of value
+	static int spread_bits(int value)
+	{
+		value = (value | (value << 8)) & 0x0300f00f;
+		value = (value | (value << 4)) & 0x030c30c3;
+		value = (value | (value << 2)) & 0x09249249;
+		return value;
+	}
+
 	const int m_x;
 	const int m_y;
 	const int m_z;
-	bool m_filled;
-	bool m_up_to_date;
-	bool m_update_queued;
-	bool m_low_priority_update;
-	bool m_reupdate;
+	std::uint8_t m_own_state;
+	std::uint8_t* m_state;
+	unsigned int m_version;
+	CancellationToken* m_update_token;
+	bool m_touched;
+	int m_idle_seconds;
+	DirtyChunkList* m_dirty_list;
+	bool m_in_dirty_list;
+	Chunk* m_prev_dirty;
+	Chunk* m_next_dirty;
 	MeshPTI m_mesh;
-	const std::shared_ptr<BlockData> m_block_data;
+	std::shared_ptr<const BlockData> m_block_data;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "chunk_cache.h"
+#include <utility>
+
+ChunkCache::ChunkCache(std::size_t capacity) :
+	m_capacity{capacity},
+	m_hits{0},
+	m_misses{0}
+{
+}
+
+std::unique_ptr<Chunk> ChunkCache::take(int chunk_x, int chunk_y, int chunk_z)
+{
+	auto it = m_index.find(Chunk::get_coord_key(chunk_x, chunk_y, chunk_z));
+
+	if (it == m_index.end())
+	{
+		++m_misses;
+		return nullptr;
+	}
+
+	++m_hits;
+
+	auto chunk = std::move(*it->second);
+	m_chunks.erase(it->second);
+	m_index.erase(it);
+
+	return chunk;
+}
+
+std::unique_ptr<Chunk> ChunkCache::put(std::unique_ptr<Chunk> chunk)
+{
+	auto key = Chunk::get_coord_key(chunk->get_x(), chunk->get_y(), chunk->get_z());
+
+	m_chunks.push_front(std::move(chunk));
+	m_index[key] = m_chunks.begin();
+
+	if (m_chunks.size() <= m_capacity)
+	{
+		return nullptr;
+	}
+
+	auto evicted = std::move(m_chunks.back());
+	m_chunks.pop_back();
+	m_index.erase(Chunk::get_coord_key(evicted->get_x(), evicted->get_y(), evicted->get_z()));
+
+	return evicted;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef CUBED_CHUNK_CACHE_H
+#define CUBED_CHUNK_CACHE_H
+
+#include "chunk.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+// Bounded least recently used cache of chunks that have been unloaded from the world, so that
+// moving back to them doesn't require generating and meshing them again.
+class ChunkCache
+{
+public:
+	ChunkCache(std::size_t capacity);
+
+	// Removes the chunk from the cache and returns it, or returns null on a miss
+	std::unique_ptr<Chunk> take(int chunk_x, int chunk_y, int chunk_z);
+
+	// Doesn't count as a hit or a miss, or change the chunk's place in the cache
+	bool contains(int chunk_x, int chunk_y, int chunk_z) const { return m_index.count(Chunk::get_coord_key(chunk_x, chunk_y, chunk_z)) != 0; }
+
+	// Returns the cached chunk, or null if it isn't cached, leaving it in the cache. Like
+	// contains, doesn't count as a hit or a miss.
+	Chunk* find(int chunk_x, int chunk_y, int chunk_z) const
+	{
+		auto it = m_index.find(Chunk::get_coord_key(chunk_x, chunk_y, chunk_z));
+		return it != m_index.end() ? it->second->get() : nullptr;
+	}
+
+	// Returns the least recently used chunk if adding this one exceeded the capacity
+	std::unique_ptr<Chunk> put(std::unique_ptr<Chunk> chunk);
+
+	auto get_size() const { return m_chunks.size(); }
+	auto get_capacity() const { return m_capacity; }
+	auto get_hits() const { return m_hits; }
+	auto get_misses() const { return m_misses; }
+
+private:
+	std::size_t m_capacity;
+	std::list<std::unique_ptr<Chunk>> m_chunks;
+	std::unordered_map<std::uint64_t, decltype(m_chunks)::iterator> m_index;
+	unsigned long long m_hits;
+	unsigned long long m_misses;
+};
+
+#endif
\ No newline at end of file
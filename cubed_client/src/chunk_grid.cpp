@@ -0,0 +1,85 @@
+#include "chunk_grid.h"
+#include <utility>
+
+ChunkGrid::Slots::Slots(int radius) :
+	radius{radius},
+	size{2 * radius + 1},
+	chunks{new std::atomic<Chunk*>[size * size * size]()},
+	chunk_x{new int[size * size * size]()},
+	chunk_y{new int[size * size * size]()},
+	chunk_z{new int[size * size * size]()},
+	states{new std::uint8_t[size * size * size]()}
+{
+}
+
+ChunkGrid::ChunkGrid(int radius, EpochManager& epochs) :
+	m_slots{new Slots{radius}},
+	m_epochs(epochs)
+{
+}
+
+ChunkGrid::~ChunkGrid()
+{
+	std::unique_ptr<Slots> slots{m_slots.load()};
+
+	for (int i = 0; i < slots->size * slots->size * slots->size; ++i)
+	{
+		delete slots->chunks[i].load();
+	}
+}
+
+void ChunkGrid::set_slot(int chunk_x, int chunk_y, int chunk_z, std::unique_ptr<Chunk> chunk)
+{
+	auto slots = m_slots.load();
+	slots->insert(slots->get_index(chunk_x, chunk_y, chunk_z), chunk.release());
+}
+
+std::unique_ptr<Chunk> ChunkGrid::take_slot(int chunk_x, int chunk_y, int chunk_z)
+{
+	auto slots = m_slots.load();
+	auto index = slots->get_index(chunk_x, chunk_y, chunk_z);
+
+	std::unique_ptr<Chunk> chunk{slots->chunks[index].exchange(nullptr)};
+
+	if (chunk)
+	{
+		chunk->move_state(nullptr);
+		slots->states[index] = 0;
+	}
+
+	return chunk;
+}
+
+void ChunkGrid::resize(int radius, int center_x, int center_y, int center_z, std::function<void(std::unique_ptr<Chunk>)> unload)
+{
+	std::unique_ptr<Slots> old_slots{m_slots.load()};
+	auto slots = std::make_unique<Slots>(radius);
+
+	// Only chunks inside the new cube are kept. The cube maps one to one onto the slots, so
+	// none of them can collide.
+	for (int i = 0; i < old_slots->size * old_slots->size * old_slots->size; ++i)
+	{
+		std::unique_ptr<Chunk> chunk{old_slots->chunks[i].load()};
+
+		if (!chunk)
+		{
+			continue;
+		}
+
+		if (chunk->get_x() >= center_x - radius && chunk->get_x() <= center_x + radius &&
+			chunk->get_y() >= center_y - radius && chunk->get_y() <= center_y + radius &&
+			chunk->get_z() >= center_z - radius && chunk->get_z() <= center_z + radius)
+		{
+			auto index = slots->get_index(chunk->get_x(), chunk->get_y(), chunk->get_z());
+			slots->insert(index, chunk.release());
+		}
+		else
+		{
+			chunk->move_state(nullptr);
+			unload(std::move(chunk));
+		}
+	}
+
+	m_slots = slots.release();
+	m_epochs.retire(std::move(old_slots));
+}
\ No newline at end of file
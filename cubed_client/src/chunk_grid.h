@@ -0,0 +1,134 @@
+#ifndef CUBED_CHUNK_GRID_H
+#define CUBED_CHUNK_GRID_H
+
+#include "chunk.h"
+#include "epoch_manager.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// Fixed size ring buffer of chunks covering the (2 * radius + 1)^3 cube around a center chunk.
+// Chunk coordinates are mapped to slots modulo the grid size, so every chunk in the cube has
+// exactly one slot and moving the cube only replaces the chunks that wrapped around.
+//
+// Alongside the chunks the grid keeps a structure of arrays table of per slot metadata: the
+// coordinates and state bits of the chunk in each slot. Passes over every loaded chunk stream
+// through the table and only touch the chunks they need to.
+//
+// Only the owning thread modifies the grid. Other threads can look chunks up without locking
+// while they hold an epoch guard, since chunks and slot arrays that are removed from the grid
+// are retired to the epoch manager rather than deleted.
+class ChunkGrid
+{
+public:
+	ChunkGrid(int radius, EpochManager& epochs);
+	~ChunkGrid();
+
+	ChunkGrid(const ChunkGrid&) = delete;
+	ChunkGrid& operator=(const ChunkGrid&) = delete;
+
+	// Chunks outside the new cube are taken out of the grid and passed to unload, which has to
+	// retire them to the epoch manager once it is done with them
+	void resize(int radius, int center_x, int center_y, int center_z, std::function<void(std::unique_ptr<Chunk>)> unload);
+
+	Chunk* get(int chunk_x, int chunk_y, int chunk_z) const
+	{
+		auto chunk = m_slots.load(std::memory_order_acquire)->get(chunk_x, chunk_y, chunk_z).load(std::memory_order_acquire);
+
+		if (chunk && chunk->get_x() == chunk_x && chunk->get_y() == chunk_y && chunk->get_z() == chunk_z)
+		{
+			return chunk;
+		}
+
+		return nullptr;
+	}
+
+	// Returns the chunk in the slot that the given chunk coordinates map to. The slot may be
+	// empty or hold a different chunk that wrapped around from the other side of the cube.
+	Chunk* get_slot(int chunk_x, int chunk_y, int chunk_z) const { return m_slots.load()->get(chunk_x, chunk_y, chunk_z); }
+
+	// True if the slot the coordinates map to holds a chunk with different coordinates
+	bool holds_other_chunk(int chunk_x, int chunk_y, int chunk_z) const
+	{
+		auto slots = m_slots.load();
+		auto index = slots->get_index(chunk_x, chunk_y, chunk_z);
+
+		return slots->chunks[index].load() &&
+			(slots->chunk_x[index] != chunk_x || slots->chunk_y[index] != chunk_y || slots->chunk_z[index] != chunk_z);
+	}
+
+	// The slot must be empty
+	void set_slot(int chunk_x, int chunk_y, int chunk_z, std::unique_ptr<Chunk> chunk);
+
+	// Empties the slot. Other threads may still be reading the chunk, so it has to be retired
+	// to the epoch manager rather than deleted.
+	std::unique_ptr<Chunk> take_slot(int chunk_x, int chunk_y, int chunk_z);
+
+	// Calls callback for each chunk whose state has all of the given bits set, or for every
+	// chunk if none are given. Stops early if callback returns false.
+	template<typename Callback>
+	void for_each(Callback callback, std::uint8_t state = 0)
+	{
+		auto slots = m_slots.load();
+		int num_slots = slots->size * slots->size * slots->size;
+
+		for (int i = 0; i < num_slots; ++i)
+		{
+			if ((slots->states[i] & state) != state)
+			{
+				continue;
+			}
+
+			auto chunk = slots->chunks[i].load();
+
+			if (chunk && !callback(chunk))
+			{
+				return;
+			}
+		}
+	}
+
+	auto get_radius() const { return m_slots.load()->radius; }
+	auto get_size() const { return m_slots.load()->size; }
+
+private:
+	struct Slots
+	{
+		Slots(int radius);
+
+		int wrap(int chunk_coord) const
+		{
+			int slot_coord = chunk_coord % size;
+			return slot_coord < 0 ? slot_coord + size : slot_coord;
+		}
+
+		int get_index(int chunk_x, int chunk_y, int chunk_z) const { return (wrap(chunk_x) * size + wrap(chunk_z)) * size + wrap(chunk_y); }
+		std::atomic<Chunk*>& get(int chunk_x, int chunk_y, int chunk_z) const { return chunks[get_index(chunk_x, chunk_y, chunk_z)]; }
+
+		// Stores the chunk in its slot, moving its state bits into the table
+		void insert(int index, Chunk* chunk)
+		{
+			chunk_x[index] = chunk->get_x();
+			chunk_y[index] = chunk->get_y();
+			chunk_z[index] = chunk->get_z();
+			chunk->move_state(&states[index]);
+			chunks[index] = chunk;
+		}
+
+		const int radius;
+		const int size;
+
+		// The only columns other threads may read are the chunk pointers
+		const std::unique_ptr<std::atomic<Chunk*>[]> chunks;
+		const std::unique_ptr<int[]> chunk_x;
+		const std::unique_ptr<int[]> chunk_y;
+		const std::unique_ptr<int[]> chunk_z;
+		const std::unique_ptr<std::uint8_t[]> states;
+	};
+
+	std::atomic<Slots*> m_slots;
+	EpochManager& m_epochs;
+};
+
+#endif
\ No newline at end of file
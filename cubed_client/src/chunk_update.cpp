@@ -2,6 +2,7 @@
 #include "world.h"
 #include "world_constants.h"
 #include "world_gen/world_gen.h"
+#include <cstdint>
 
 World* ChunkUpdate::s_world;
 
@@ -9,31 +10,81 @@ void ChunkUpdate::run()
 {
 	if (m_fill)
 	{
-		WorldGen::fill_chunk(*m_block_data, m_chunk_x * WorldConstants::CHUNK_SIZE, m_chunk_y * WorldConstants::CHUNK_SIZE, m_chunk_z * WorldConstants::CHUNK_SIZE);
+		m_generated_block_data = BlockData::create();
+		WorldGen::fill_chunk(*m_generated_block_data, m_chunk_x * WorldConstants::CHUNK_SIZE, m_chunk_y * WorldConstants::CHUNK_SIZE, m_chunk_z * WorldConstants::CHUNK_SIZE);
+
+		// A chunk unloaded while it was generated drops its blocks here rather than holding on
+		// to them until the update is drained
+		if (m_cancellation.cancelled())
+		{
+			m_generated_block_data.reset();
+			return;
+		}
+
+		m_complete = true;
+
+		return;
+	}
+
+	m_vertices.clear();
+	m_indices.clear();
+
+	bool uniform = m_block_data->is_uniform();
+
+	if (uniform && !s_world->get_block_properties(m_block_data->get_uniform_type()).render)
+	{
+		// Nothing to render in a chunk of air
+		m_complete = true;
+		return;
+	}
+
+	gather_opaque_columns();
+
+	if (!uniform)
+	{
+		m_block_data->get_all(m_blocks);
 	}
-	
-	int vi = 0;
-	int ii = 0;
 
 	for (int x = 0; x < WorldConstants::CHUNK_SIZE; ++x)
 	{
+		// Checked once per slice, which is cheap next to meshing the slice
+		if (m_cancellation.cancelled())
+		{
+			return;
+		}
+
 		for (int z = 0; z < WorldConstants::CHUNK_SIZE; ++z)
 		{
-			for (int y = 0; y < WorldConstants::CHUNK_SIZE; ++y)
+			auto column = get_opaque_column(x, z);
+
+			if (!column)
 			{
-				auto& props = s_world->get_block_properties(get_block_type(x, y, z));
+				continue;
+			}
 
-				if (!props.render)
-				{
-					continue;
-				}
+			// A face is visible wherever an opaque block's neighbour in that direction isn't
+			// opaque, which is worked out for the whole column at once.
+			auto above = m_opaque_above[x * WorldConstants::CHUNK_SIZE + z] & 1;
+			auto below = m_opaque_below[x * WorldConstants::CHUNK_SIZE + z] >> (WorldConstants::CHUNK_SIZE - 1);
+			auto front = column & ~get_opaque_column(x, z - 1);
+			auto back = column & ~get_opaque_column(x, z + 1);
+			auto left = column & ~get_opaque_column(x + 1, z);
+			auto right = column & ~get_opaque_column(x - 1, z);
+			auto bottom = column & ~((column << 1) | below);
+			auto top = column & ~((column >> 1) | (above << (WorldConstants::CHUNK_SIZE - 1)));
+
+			for (auto visible = front | back | left | right | bottom | top; visible; visible &= visible - 1)
+			{
+				int y = BlockData::get_lowest_bit(visible);
+				auto bit = std::uint64_t{1} << y;
+				auto& props = s_world->get_block_properties(get_block_type(x, y, z));
 
 				int abs_x = m_chunk_x * WorldConstants::CHUNK_SIZE + x;
 				int abs_y = m_chunk_y * WorldConstants::CHUNK_SIZE + y;
 				int abs_z = m_chunk_z * WorldConstants::CHUNK_SIZE + z;
 
 				// Front Face
-				if (!s_world->get_block_properties(get_block_type(x, y, z - 1)).render)
+				if (front & bit)
 				{
 					auto tex = props.tex_front;
 					float tex_l = (static_cast<float>(tex.first) * WorldConstants::TEXTURE_STRIDE + WorldConstants::TEXTURE_PADDING) / WorldConstants::TEXTURE_ATLAS_SIZE;
@@ -41,27 +92,16 @@ void ChunkUpdate::run()
 					float tex_t = (static_cast<float>(tex.second) * WorldConstants::TEXTURE_STRIDE + WorldConstants::TEXTURE_PADDING) / WorldConstants::TEXTURE_ATLAS_SIZE;
 					float tex_b = tex_t + static_cast<float>(WorldConstants::TEXTURE_SIZE) / WorldConstants::TEXTURE_ATLAS_SIZE;
 
-					m_vertices[vi].position = glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y), static_cast<float>(abs_z));
-					m_vertices[vi].tex_coord = glm::vec2(tex_r, tex_b);
-					m_vertices[vi + 1].position = glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y + 1), static_cast<float>(abs_z));
-					m_vertices[vi + 1].tex_coord = glm::vec2(tex_r, tex_t);
-					m_vertices[vi + 2].position = glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y), static_cast<float>(abs_z));
-					m_vertices[vi + 2].tex_coord = glm::vec2(tex_l, tex_b);
-					m_vertices[vi + 3].position = glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y + 1), static_cast<float>(abs_z));
-					m_vertices[vi + 3].tex_coord = glm::vec2(tex_l, tex_t);
-
-					m_indices[ii++] = vi;
-					m_indices[ii++] = vi + 1;
-					m_indices[ii++] = vi + 2;
-					m_indices[ii++] = vi + 2;
-					m_indices[ii++] = vi + 1;
-					m_indices[ii++] = vi + 3;
-
-					vi += 4;
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y), static_cast<float>(abs_z)), glm::vec2(tex_r, tex_b));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y + 1), static_cast<float>(abs_z)), glm::vec2(tex_r, tex_t));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y), static_cast<float>(abs_z)), glm::vec2(tex_l, tex_b));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y + 1), static_cast<float>(abs_z)), glm::vec2(tex_l, tex_t));
+
+					add_quad_indices();
 				}
 
 				// Back Face
-				if (!s_world->get_block_properties(get_block_type(x, y, z + 1)).render)
+				if (back & bit)
 				{
 					auto tex = props.tex_back;
 					float tex_l = (static_cast<float>(tex.first) * WorldConstants::TEXTURE_STRIDE + WorldConstants::TEXTURE_PADDING) / WorldConstants::TEXTURE_ATLAS_SIZE;
@@ -69,27 +109,16 @@ void ChunkUpdate::run()
 					float tex_t = (static_cast<float>(tex.second) * WorldConstants::TEXTURE_STRIDE + WorldConstants::TEXTURE_PADDING) / WorldConstants::TEXTURE_ATLAS_SIZE;
 					float tex_b = tex_t + static_cast<float>(WorldConstants::TEXTURE_SIZE) / WorldConstants::TEXTURE_ATLAS_SIZE;
 
-					m_vertices[vi].position = glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y), static_cast<float>(abs_z + 1));
-					m_vertices[vi].tex_coord = glm::vec2(tex_l, tex_b);
-					m_vertices[vi + 1].position = glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y), static_cast<float>(abs_z + 1));
-					m_vertices[vi + 1].tex_coord = glm::vec2(tex_r, tex_b);
-					m_vertices[vi + 2].position = glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y + 1), static_cast<float>(abs_z + 1));
-					m_vertices[vi + 2].tex_coord = glm::vec2(tex_l, tex_t);
-					m_vertices[vi + 3].position = glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y + 1), static_cast<float>(abs_z + 1));
-					m_vertices[vi + 3].tex_coord = glm::vec2(tex_r, tex_t);
-
-					m_indices[ii++] = vi;
-					m_indices[ii++] = vi + 1;
-					m_indices[ii++] = vi + 2;
-					m_indices[ii++] = vi + 2;
-					m_indices[ii++] = vi + 1;
-					m_indices[ii++] = vi + 3;
-
-					vi += 4;
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y), static_cast<float>(abs_z + 1)), glm::vec2(tex_l, tex_b));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y), static_cast<float>(abs_z + 1)), glm::vec2(tex_r, tex_b));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y + 1), static_cast<float>(abs_z + 1)), glm::vec2(tex_l, tex_t));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y + 1), static_cast<float>(abs_z + 1)), glm::vec2(tex_r, tex_t));
+
+					add_quad_indices();
 				}
 
 				// Left Face
-				if (!s_world->get_block_properties(get_block_type(x + 1, y, z)).render)
+				if (left & bit)
 				{
 					auto tex = props.tex_left;
 					float tex_l = (static_cast<float>(tex.first) * WorldConstants::TEXTURE_STRIDE + WorldConstants::TEXTURE_PADDING) / WorldConstants::TEXTURE_ATLAS_SIZE;
@@ -97,27 +126,16 @@ void ChunkUpdate::run()
 					float tex_t = (static_cast<float>(tex.second) * WorldConstants::TEXTURE_STRIDE + WorldConstants::TEXTURE_PADDING) / WorldConstants::TEXTURE_ATLAS_SIZE;
 					float tex_b = tex_t + static_cast<float>(WorldConstants::TEXTURE_SIZE) / WorldConstants::TEXTURE_ATLAS_SIZE;
 
-					m_vertices[vi].position = glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y), static_cast<float>(abs_z));
-					m_vertices[vi].tex_coord = glm::vec2(tex_r, tex_b);
-					m_vertices[vi + 1].position = glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y + 1), static_cast<float>(abs_z));
-					m_vertices[vi + 1].tex_coord = glm::vec2(tex_r, tex_t);
-					m_vertices[vi + 2].position = glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y), static_cast<float>(abs_z + 1));
-					m_vertices[vi + 2].tex_coord = glm::vec2(tex_l, tex_b);
-					m_vertices[vi + 3].position = glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y + 1), static_cast<float>(abs_z + 1));
-					m_vertices[vi + 3].tex_coord = glm::vec2(tex_l, tex_t);
-
-					m_indices[ii++] = vi;
-					m_indices[ii++] = vi + 1;
-					m_indices[ii++] = vi + 2;
-					m_indices[ii++] = vi + 2;
-					m_indices[ii++] = vi + 1;
-					m_indices[ii++] = vi + 3;
-
-					vi += 4;
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y), static_cast<float>(abs_z)), glm::vec2(tex_r, tex_b));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y + 1), static_cast<float>(abs_z)), glm::vec2(tex_r, tex_t));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y), static_cast<float>(abs_z + 1)), glm::vec2(tex_l, tex_b));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y + 1), static_cast<float>(abs_z + 1)), glm::vec2(tex_l, tex_t));
+
+					add_quad_indices();
 				}
 
 				// Right Face
-				if (!s_world->get_block_properties(get_block_type(x - 1, y, z)).render)
+				if (right & bit)
 				{
 					auto tex = props.tex_right;
 					float tex_l = (static_cast<float>(tex.first) * WorldConstants::TEXTURE_STRIDE + WorldConstants::TEXTURE_PADDING) / WorldConstants::TEXTURE_ATLAS_SIZE;
@@ -125,27 +143,16 @@ void ChunkUpdate::run()
 					float tex_t = (static_cast<float>(tex.second) * WorldConstants::TEXTURE_STRIDE + WorldConstants::TEXTURE_PADDING) / WorldConstants::TEXTURE_ATLAS_SIZE;
 					float tex_b = tex_t + static_cast<float>(WorldConstants::TEXTURE_SIZE) / WorldConstants::TEXTURE_ATLAS_SIZE;
 
-					m_vertices[vi].position = glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y), static_cast<float>(abs_z));
-					m_vertices[vi].tex_coord = glm::vec2(tex_l, tex_b);
-					m_vertices[vi + 1].position = glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y), static_cast<float>(abs_z + 1));
-					m_vertices[vi + 1].tex_coord = glm::vec2(tex_r, tex_b);
-					m_vertices[vi + 2].position = glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y + 1), static_cast<float>(abs_z));
-					m_vertices[vi + 2].tex_coord = glm::vec2(tex_l, tex_t);
-					m_vertices[vi + 3].position = glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y + 1), static_cast<float>(abs_z + 1));
-					m_vertices[vi + 3].tex_coord = glm::vec2(tex_r, tex_t);
-
-					m_indices[ii++] = vi;
-					m_indices[ii++] = vi + 1;
-					m_indices[ii++] = vi + 2;
-					m_indices[ii++] = vi + 2;
-					m_indices[ii++] = vi + 1;
-					m_indices[ii++] = vi + 3;
-
-					vi += 4;
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y), static_cast<float>(abs_z)), glm::vec2(tex_l, tex_b));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y), static_cast<float>(abs_z + 1)), glm::vec2(tex_r, tex_b));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y + 1), static_cast<float>(abs_z)), glm::vec2(tex_l, tex_t));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y + 1), static_cast<float>(abs_z + 1)), glm::vec2(tex_r, tex_t));
+
+					add_quad_indices();
 				}
 
 				// Bottom Face
-				if (!s_world->get_block_properties(get_block_type(x, y - 1, z)).render)
+				if (bottom & bit)
 				{
 					auto tex = props.tex_bottom;
 					float tex_l = (static_cast<float>(tex.first) * WorldConstants::TEXTURE_STRIDE + WorldConstants::TEXTURE_PADDING) / WorldConstants::TEXTURE_ATLAS_SIZE;
@@ -153,27 +160,16 @@ void ChunkUpdate::run()
 					float tex_t = (static_cast<float>(tex.second) * WorldConstants::TEXTURE_STRIDE + WorldConstants::TEXTURE_PADDING) / WorldConstants::TEXTURE_ATLAS_SIZE;
 					float tex_b = tex_t + static_cast<float>(WorldConstants::TEXTURE_SIZE) / WorldConstants::TEXTURE_ATLAS_SIZE;
 
-					m_vertices[vi].position = glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y), static_cast<float>(abs_z + 1));
-					m_vertices[vi].tex_coord = glm::vec2(tex_r, tex_b);
-					m_vertices[vi + 1].position = glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y), static_cast<float>(abs_z));
-					m_vertices[vi + 1].tex_coord = glm::vec2(tex_r, tex_t);
-					m_vertices[vi + 2].position = glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y), static_cast<float>(abs_z + 1));
-					m_vertices[vi + 2].tex_coord = glm::vec2(tex_l, tex_b);
-					m_vertices[vi + 3].position = glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y), static_cast<float>(abs_z));
-					m_vertices[vi + 3].tex_coord = glm::vec2(tex_l, tex_t);
-
-					m_indices[ii++] = vi;
-					m_indices[ii++] = vi + 1;
-					m_indices[ii++] = vi + 2;
-					m_indices[ii++] = vi + 2;
-					m_indices[ii++] = vi + 1;
-					m_indices[ii++] = vi + 3;
-
-					vi += 4;
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y), static_cast<float>(abs_z + 1)), glm::vec2(tex_r, tex_b));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y), static_cast<float>(abs_z)), glm::vec2(tex_r, tex_t));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y), static_cast<float>(abs_z + 1)), glm::vec2(tex_l, tex_b));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y), static_cast<float>(abs_z)), glm::vec2(tex_l, tex_t));
+
+					add_quad_indices();
 				}
 
 				// Top Face
-				if (!s_world->get_block_properties(get_block_type(x, y + 1, z)).render)
+				if (top & bit)
 				{
 					auto tex = props.tex_top;
 					float tex_l = (static_cast<float>(tex.first) * WorldConstants::TEXTURE_STRIDE + WorldConstants::TEXTURE_PADDING) / WorldConstants::TEXTURE_ATLAS_SIZE;
@@ -181,42 +177,65 @@ void ChunkUpdate::run()
 					float tex_t = (static_cast<float>(tex.second) * WorldConstants::TEXTURE_STRIDE + WorldConstants::TEXTURE_PADDING) / WorldConstants::TEXTURE_ATLAS_SIZE;
 					float tex_b = tex_t + static_cast<float>(WorldConstants::TEXTURE_SIZE) / WorldConstants::TEXTURE_ATLAS_SIZE;
 
-					m_vertices[vi].position = glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y + 1), static_cast<float>(abs_z + 1));
-					m_vertices[vi].tex_coord = glm::vec2(tex_l, tex_t);
-					m_vertices[vi + 1].position = glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y + 1), static_cast<float>(abs_z + 1));
-					m_vertices[vi + 1].tex_coord = glm::vec2(tex_r, tex_t);
-					m_vertices[vi + 2].position = glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y + 1), static_cast<float>(abs_z));
-					m_vertices[vi + 2].tex_coord = glm::vec2(tex_l, tex_b);
-					m_vertices[vi + 3].position = glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y + 1), static_cast<float>(abs_z));
-					m_vertices[vi + 3].tex_coord = glm::vec2(tex_r, tex_b);
-
-					m_indices[ii++] = vi;
-					m_indices[ii++] = vi + 1;
-					m_indices[ii++] = vi + 2;
-					m_indices[ii++] = vi + 2;
-					m_indices[ii++] = vi + 1;
-					m_indices[ii++] = vi + 3;
-
-					vi += 4;
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y + 1), static_cast<float>(abs_z + 1)), glm::vec2(tex_l, tex_t));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y + 1), static_cast<float>(abs_z + 1)), glm::vec2(tex_r, tex_t));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x), static_cast<float>(abs_y + 1), static_cast<float>(abs_z)), glm::vec2(tex_l, tex_b));
+					m_vertices.emplace_back(glm::vec3(static_cast<float>(abs_x + 1), static_cast<float>(abs_y + 1), static_cast<float>(abs_z)), glm::vec2(tex_r, tex_b));
+
+					add_quad_indices();
 				}
 			}
 		}
 	}
 
-	m_num_vertices = vi;
-	m_num_indices = ii;
+	m_complete = true;
 }
 
-BlockType ChunkUpdate::get_block_type(int x, int y, int z) const
+void ChunkUpdate::gather_opaque_columns()
 {
-	if (x < 0 || x >= WorldConstants::CHUNK_SIZE || y < 0 || y >= WorldConstants::CHUNK_SIZE || z < 0 || z >= WorldConstants::CHUNK_SIZE)
+	const int last = WorldConstants::CHUNK_SIZE - 1;
+
+	for (int x = 0; x < WorldConstants::CHUNK_SIZE; ++x)
 	{
-		return s_world->get_block_type(m_chunk_x * WorldConstants::CHUNK_SIZE + x, m_chunk_y * WorldConstants::CHUNK_SIZE + y, m_chunk_z * WorldConstants::CHUNK_SIZE + z);
+		for (int z = 0; z < WorldConstants::CHUNK_SIZE; ++z)
+		{
+			m_opaque_columns[get_column_index(x, z)] = m_block_data->get_opaque_column(x, z);
+		}
 	}
 
-	auto block_index = Chunk::get_block_index(x, y, z);
-	
-	std::lock_guard<decltype(m_block_data->mutex)> lock(m_block_data->mutex);
+	// Copies columns from the neighbour at the given offset. get_target maps a column of the
+	// neighbour to where it is stored.
+	auto gather_neighbour = [this](int offset_x, int offset_y, int offset_z, int first_x, int last_x, int first_z, int last_z, auto get_target)
+	{
+		auto block_data = s_world->get_chunk_block_data(m_chunk_x + offset_x, m_chunk_y + offset_y, m_chunk_z + offset_z);
+
+		for (int x = first_x; x <= last_x; ++x)
+		{
+			for (int z = first_z; z <= last_z; ++z)
+			{
+				get_target(x, z) = block_data ? block_data->get_opaque_column(x, z) : 0;
+			}
+		}
+	};
+
+	// Only the columns along the four sides and the ends of the columns above and below are
+	// needed, the edges and corners of the padding are unused.
+	gather_neighbour(-1, 0, 0, last, last, 0, last, [this](int, int z) -> auto& { return m_opaque_columns[get_column_index(-1, z)]; });
+	gather_neighbour(1, 0, 0, 0, 0, 0, last, [this, last](int, int z) -> auto& { return m_opaque_columns[get_column_index(last + 1, z)]; });
+	gather_neighbour(0, 0, -1, 0, last, last, last, [this](int x, int) -> auto& { return m_opaque_columns[get_column_index(x, -1)]; });
+	gather_neighbour(0, 0, 1, 0, last, 0, 0, [this, last](int x, int) -> auto& { return m_opaque_columns[get_column_index(x, last + 1)]; });
+	gather_neighbour(0, -1, 0, 0, last, 0, last, [this](int x, int z) -> auto& { return m_opaque_below[x * WorldConstants::CHUNK_SIZE + z]; });
+	gather_neighbour(0, 1, 0, 0, last, 0, last, [this](int x, int z) -> auto& { return m_opaque_above[x * WorldConstants::CHUNK_SIZE + z]; });
+}
 
-	return m_block_data->blocks[block_index];
+void ChunkUpdate::add_quad_indices()
+{
+	auto vi = static_cast<Index>(m_vertices.size() - 4);
+
+	m_indices.push_back(vi);
+	m_indices.push_back(vi + 1);
+	m_indices.push_back(vi + 2);
+	m_indices.push_back(vi + 2);
+	m_indices.push_back(vi + 1);
+	m_indices.push_back(vi + 3);
 }
\ No newline at end of file
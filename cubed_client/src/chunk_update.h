@@ -1,54 +1,116 @@
 #ifndef CUBED_CHUNK_UPDATE_H
 #define CUBED_CHUNK_UPDATE_H
 
+#include "cancellation_token.h"
 #include "chunk.h"
 #include "world_constants.h"
-#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 class World;
 
+// Fill updates generate a chunk's blocks. Other updates build the mesh from the blocks the
+// chunk already has, and are only made once the chunk's neighbours have been generated too.
 class ChunkUpdate
 {
 public:
-	ChunkUpdate(std::shared_ptr<BlockData> block_data, int chunk_x, int chunk_y, int chunk_z, bool fill) :
-		m_finished{false},
-		m_block_data{std::move(block_data)},
-		m_chunk_x{chunk_x},
-		m_chunk_y{chunk_y},
-		m_chunk_z{chunk_z},
-		m_fill(fill)
+	// 16 bit indices are enough for 16^3 chunks but not for anything larger
+	typedef std::conditional<WorldConstants::CHUNK_SIZE <= 16, unsigned short, unsigned int>::type Index;
+
+	ChunkUpdate(std::shared_ptr<const BlockData> block_data, unsigned int version, int chunk_x, int chunk_y, int chunk_z, bool fill)
+	{
+		reset(std::move(block_data), version, chunk_x, chunk_y, chunk_z, fill);
+	}
+
+	// Prepares a finished update to be reused for another chunk. The vertex and index buffers
+	// keep their capacity, so reused updates rarely allocate.
+	void reset(std::shared_ptr<const BlockData> block_data, unsigned int version, int chunk_x, int chunk_y, int chunk_z, bool fill)
 	{
+		m_next_completed = nullptr;
+		m_cancellation.reset();
+		m_complete = false;
+		m_prefetch = false;
+		m_block_data = std::move(block_data);
+		m_generated_block_data.reset();
+		m_version = version;
+		m_chunk_x = chunk_x;
+		m_chunk_y = chunk_y;
+		m_chunk_z = chunk_z;
+		m_fill = fill;
 	}
 
+	// The thread running the update must hold an epoch guard, since the update looks up the
+	// neighbouring chunks to copy their opaque masks. Stops early if the update is cancelled.
 	void run();
-	void set_finished() { m_finished = true; }
 
-	bool finished() const { return m_finished; }
+	// Cancelled by the world when the chunk leaves the grid
+	auto& get_cancellation_token() { return m_cancellation; }
+	const auto& get_cancellation_token() const { return m_cancellation; }
+
+	// True if run got to the end without being cancelled
+	bool complete() const { return m_complete; }
+	bool is_fill() const { return m_fill; }
+
+	// Prefetches generate chunks that aren't loaded yet, and only run when the workers are idle
+	bool is_prefetch() const { return m_prefetch; }
+	void set_prefetch(bool prefetch) { m_prefetch = prefetch; }
+
+	// Link for the world's completion queue
+	ChunkUpdate* get_next_completed() const { return m_next_completed; }
+	void set_next_completed(ChunkUpdate* next) { m_next_completed = next; }
+
+	auto get_version() const { return m_version; }
+
+	// Only set by fill updates
+	const auto& get_generated_block_data() const { return m_generated_block_data; }
 	auto get_x() const { return m_chunk_x; }
 	auto get_y() const { return m_chunk_y; }
 	auto get_z() const { return m_chunk_z; }
 	const auto& get_vertices() const { return m_vertices; }
 	const auto& get_indices() const { return m_indices; }
-	auto get_num_vertices() const { return m_num_vertices; }
-	auto get_num_indices() const { return m_num_indices; }
+	auto get_num_vertices() const { return static_cast<GLsizei>(m_vertices.size()); }
+	auto get_num_indices() const { return static_cast<GLsizei>(m_indices.size()); }
+
+	// Bytes uploaded to the GPU when the mesh is set on the chunk
+	std::size_t get_mesh_size() const { return m_vertices.size() * sizeof(VertexPT) + m_indices.size() * sizeof(Index); }
 
 	static void set_world(World* world) { s_world = world; }
 
 private:
-	BlockType get_block_type(int x, int y, int z) const;
+	static const int PADDED_SIZE = WorldConstants::CHUNK_SIZE + 2;
 
-	std::atomic_bool m_finished;
-	std::shared_ptr<BlockData> m_block_data;
+	static int get_column_index(int x, int z) { return (x + 1) * PADDED_SIZE + z + 1; }
+
+	void gather_opaque_columns();
+	void add_quad_indices();
+	BlockType get_block_type(int x, int y, int z) const { return m_block_data->is_uniform() ? m_block_data->get_uniform_type() : m_blocks[Chunk::get_block_index(x, y, z)]; }
+	std::uint64_t get_opaque_column(int x, int z) const { return m_opaque_columns[get_column_index(x, z)]; }
+
+	ChunkUpdate* m_next_completed;
+	CancellationToken m_cancellation;
+	bool m_complete;
+	bool m_prefetch;
+	std::shared_ptr<const BlockData> m_block_data;
+	std::shared_ptr<BlockData> m_generated_block_data;
+	unsigned int m_version;
 	int m_chunk_x;
 	int m_chunk_y;
 	int m_chunk_z;
 	bool m_fill;
-	std::array<VertexPT, WorldConstants::CHUNK_NUM_BLOCKS * WorldConstants::VERTICES_PER_BLOCK> m_vertices;
-	std::array<unsigned short, WorldConstants::CHUNK_NUM_BLOCKS * WorldConstants::INDICES_PER_BLOCK> m_indices;
-	GLsizei m_num_vertices;
-	GLsizei m_num_indices;
+	BlockData::BlockArray m_blocks;
+
+	// Opaque masks of this chunk's columns padded with the adjacent columns of the four
+	// neighbours at its sides, and the columns of the neighbours above and below it
+	std::array<std::uint64_t, PADDED_SIZE * PADDED_SIZE> m_opaque_columns;
+	std::array<std::uint64_t, WorldConstants::CHUNK_NUM_BLOCKS / WorldConstants::CHUNK_SIZE> m_opaque_below;
+	std::array<std::uint64_t, WorldConstants::CHUNK_NUM_BLOCKS / WorldConstants::CHUNK_SIZE> m_opaque_above;
+	std::vector<VertexPT> m_vertices;
+	std::vector<Index> m_indices;
 
 	static World* s_world;
 };
@@ -0,0 +1,62 @@
+#include "chunk.h"
+#include "chunk_update_queue.h"
+#include "world_constants.h"
+#include <algorithm>
+
+const float ChunkUpdateQueue::OUT_OF_VIEW_FACTOR = 4.0f;
+const float ChunkUpdateQueue::LOAD_FACTOR = 2.0f;
+
+void ChunkUpdateQueue::set_view(const glm::vec3& position, const glm::mat4& view_projection)
+{
+	m_position = position;
+	m_frustum = Frustum{view_projection};
+}
+
+void ChunkUpdateQueue::push(Chunk* chunk)
+{
+	m_entries.push_back({get_cost(*chunk), chunk});
+	m_heap_valid = false;
+}
+
+Chunk* ChunkUpdateQueue::pop()
+{
+	if (m_entries.empty())
+	{
+		return nullptr;
+	}
+
+	if (!m_heap_valid)
+	{
+		std::make_heap(m_entries.begin(), m_entries.end());
+		m_heap_valid = true;
+	}
+
+	std::pop_heap(m_entries.begin(), m_entries.end());
+	auto chunk = m_entries.back().chunk;
+	m_entries.pop_back();
+
+	return chunk;
+}
+
+float ChunkUpdateQueue::get_cost(const Chunk& chunk) const
+{
+	const float chunk_size = static_cast<float>(WorldConstants::CHUNK_SIZE);
+
+	glm::vec3 low(chunk.get_x() * chunk_size, chunk.get_y() * chunk_size, chunk.get_z() * chunk_size);
+	glm::vec3 high = low + chunk_size;
+
+	// Distance to the nearest point of the chunk, so the chunk the camera is in costs nothing
+	float cost = glm::length(glm::clamp(m_position, low, high) - m_position);
+
+	if (!m_frustum.intersects({low, high}))
+	{
+		cost *= OUT_OF_VIEW_FACTOR;
+	}
+
+	if (chunk.low_priority_update())
+	{
+		cost *= LOAD_FACTOR;
+	}
+
+	return cost;
+}
\ No newline at end of file
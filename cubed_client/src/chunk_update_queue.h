@@ -0,0 +1,55 @@
+#ifndef CUBED_CHUNK_UPDATE_QUEUE_H
+#define CUBED_CHUNK_UPDATE_QUEUE_H
+
+#include "frustum.h"
+#include <cstddef>
+#include <glm/include/glm.hpp>
+#include <vector>
+
+class Chunk;
+
+// Priority queue of chunks waiting for a chunk update, nearest first. Chunks outside the view
+// frustum count as further away than they are, and chunks that have been updated before (edits
+// and remeshes) as closer than fresh loads, so that what the player is looking at or changing
+// appears first. Priorities depend on the camera, so the world rebuilds the queue from its
+// dirty list every frame rather than the queue keeping chunks between frames.
+class ChunkUpdateQueue
+{
+public:
+	ChunkUpdateQueue() :
+		m_heap_valid{true}
+	{
+	}
+
+	void set_view(const glm::vec3& position, const glm::mat4& view_projection);
+
+	// Chunks can be pushed in any order. The heap is only built on the first pop.
+	void push(Chunk* chunk);
+	Chunk* pop();
+	void clear() { m_entries.clear(); m_heap_valid = true; }
+
+	bool empty() const { return m_entries.empty(); }
+	auto get_size() const { return m_entries.size(); }
+
+private:
+	struct Entry
+	{
+		// Inverted so that std::make_heap, which builds a max heap, puts the lowest cost on top
+		bool operator<(const Entry& other) const { return cost > other.cost; }
+
+		float cost;
+		Chunk* chunk;
+	};
+
+	float get_cost(const Chunk& chunk) const;
+
+	std::vector<Entry> m_entries;
+	bool m_heap_valid;
+	glm::vec3 m_position;
+	Frustum m_frustum;
+
+	static const float OUT_OF_VIEW_FACTOR;
+	static const float LOAD_FACTOR;
+};
+
+#endif
\ No newline at end of file
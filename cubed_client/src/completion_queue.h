@@ -0,0 +1,63 @@
+#ifndef CUBED_COMPLETION_QUEUE_H
+#define CUBED_COMPLETION_QUEUE_H
+
+#include <atomic>
+
+// Lock-free queue that any number of threads push finished work onto and a single thread
+// drains. It is intrusive: T needs get_next_completed and set_next_completed, so pushing never
+// allocates. Pushes are a compare and swap on the head of a stack, and draining swaps the whole
+// stack out at once, so the consumer pays only for what has completed.
+template<typename T>
+class CompletionQueue
+{
+public:
+	CompletionQueue() :
+		m_head{nullptr}
+	{
+	}
+
+	CompletionQueue(const CompletionQueue&) = delete;
+	CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+	void push(T* item)
+	{
+		auto head = m_head.load(std::memory_order_relaxed);
+
+		do
+		{
+			item->set_next_completed(head);
+		}
+		while (!m_head.compare_exchange_weak(head, item, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	// Takes everything pushed so far and calls callback for each item in the order they were
+	// pushed. Only one thread may drain the queue.
+	template<typename Callback>
+	void drain(Callback callback)
+	{
+		auto item = m_head.exchange(nullptr, std::memory_order_acquire);
+
+		// The stack is newest first
+		T* reversed = nullptr;
+
+		while (item)
+		{
+			auto next = item->get_next_completed();
+			item->set_next_completed(reversed);
+			reversed = item;
+			item = next;
+		}
+
+		while (reversed)
+		{
+			auto next = reversed->get_next_completed();
+			callback(reversed);
+			reversed = next;
+		}
+	}
+
+private:
+	std::atomic<T*> m_head;
+};
+
+#endif
\ No newline at end of file
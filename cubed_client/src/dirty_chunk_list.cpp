@@ -0,0 +1,62 @@
+#include "chunk.h"
+#include "dirty_chunk_list.h"
+
+void DirtyChunkList::push_back(Chunk* chunk)
+{
+	if (chunk->m_in_dirty_list)
+	{
+		return;
+	}
+
+	chunk->m_in_dirty_list = true;
+	chunk->m_prev_dirty = m_back;
+	chunk->m_next_dirty = nullptr;
+
+	if (m_back)
+	{
+		m_back->m_next_dirty = chunk;
+	}
+	else
+	{
+		m_front = chunk;
+	}
+
+	m_back = chunk;
+	++m_size;
+}
+
+void DirtyChunkList::remove(Chunk* chunk)
+{
+	if (!chunk->m_in_dirty_list)
+	{
+		return;
+	}
+
+	if (chunk->m_prev_dirty)
+	{
+		chunk->m_prev_dirty->m_next_dirty = chunk->m_next_dirty;
+	}
+	else
+	{
+		m_front = chunk->m_next_dirty;
+	}
+
+	if (chunk->m_next_dirty)
+	{
+		chunk->m_next_dirty->m_prev_dirty = chunk->m_prev_dirty;
+	}
+	else
+	{
+		m_back = chunk->m_prev_dirty;
+	}
+
+	chunk->m_in_dirty_list = false;
+	chunk->m_prev_dirty = nullptr;
+	chunk->m_next_dirty = nullptr;
+	--m_size;
+}
+
+Chunk* DirtyChunkList::get_next(const Chunk* chunk)
+{
+	return chunk->m_next_dirty;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef CUBED_DIRTY_CHUNK_LIST_H
+#define CUBED_DIRTY_CHUNK_LIST_H
+
+#include <cstddef>
+
+class Chunk;
+
+// Intrusive list of chunks that may need a chunk update. Chunks add themselves whenever they go
+// out of date, so finding work costs O(dirty chunks) rather than a walk over every loaded
+// chunk. Adding and removing are O(1) and never allocate.
+class DirtyChunkList
+{
+public:
+	DirtyChunkList() :
+		m_front{nullptr},
+		m_back{nullptr},
+		m_size{0}
+	{
+	}
+
+	DirtyChunkList(const DirtyChunkList&) = delete;
+	DirtyChunkList& operator=(const DirtyChunkList&) = delete;
+
+	// Chunks that are already in the list keep their place
+	void push_back(Chunk* chunk);
+	void remove(Chunk* chunk);
+
+	Chunk* get_front() const { return m_front; }
+	static Chunk* get_next(const Chunk* chunk);
+
+	auto get_size() const { return m_size; }
+
+private:
+	Chunk* m_front;
+	Chunk* m_back;
+	std::size_t m_size;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "chunk.h"
+#include "edit_batch.h"
+#include "world_constants.h"
+
+EditBatch::EditBatch() :
+	m_last_chunk_edit_index{0}
+{
+}
+
+void EditBatch::set_block(int x, int y, int z, BlockType type)
+{
+	int chunk_x = Chunk::get_chunk_coord(x);
+	int chunk_y = Chunk::get_chunk_coord(y);
+	int chunk_z = Chunk::get_chunk_coord(z);
+
+	int local_x = x - chunk_x * WorldConstants::CHUNK_SIZE;
+	int local_y = y - chunk_y * WorldConstants::CHUNK_SIZE;
+	int local_z = z - chunk_z * WorldConstants::CHUNK_SIZE;
+
+	auto& chunk_edits = get_chunk_edits(chunk_x, chunk_y, chunk_z);
+	chunk_edits.blocks.emplace_back(Chunk::get_block_index(local_x, local_y, local_z), type);
+
+	const int last = WorldConstants::CHUNK_SIZE - 1;
+
+	chunk_edits.boundary_faces |=
+		(local_x == 0 ? FACE_NEG_X : 0) | (local_x == last ? FACE_POS_X : 0) |
+		(local_y == 0 ? FACE_NEG_Y : 0) | (local_y == last ? FACE_POS_Y : 0) |
+		(local_z == 0 ? FACE_NEG_Z : 0) | (local_z == last ? FACE_POS_Z : 0);
+}
+
+void EditBatch::fill_box(int low_x, int low_y, int low_z, int high_x, int high_y, int high_z, BlockType type)
+{
+	for (int x = low_x; x <= high_x; ++x)
+	{
+		for (int z = low_z; z <= high_z; ++z)
+		{
+			for (int y = low_y; y <= high_y; ++y)
+			{
+				set_block(x, y, z, type);
+			}
+		}
+	}
+}
+
+void EditBatch::fill_sphere(int center_x, int center_y, int center_z, int radius, BlockType type)
+{
+	int radius_squared = radius * radius;
+
+	for (int x = -radius; x <= radius; ++x)
+	{
+		for (int z = -radius; z <= radius; ++z)
+		{
+			for (int y = -radius; y <= radius; ++y)
+			{
+				if (x * x + y * y + z * z <= radius_squared)
+				{
+					set_block(center_x + x, center_y + y, center_z + z, type);
+				}
+			}
+		}
+	}
+}
+
+void EditBatch::paste(const std::vector<BlockEdit>& blocks, int offset_x, int offset_y, int offset_z)
+{
+	for (auto& block : blocks)
+	{
+		set_block(block.x + offset_x, block.y + offset_y, block.z + offset_z, block.type);
+	}
+}
+
+void EditBatch::clear()
+{
+	m_chunk_edits.clear();
+	m_chunk_edit_indices.clear();
+	m_last_chunk_edit_index = 0;
+}
+
+EditBatch::ChunkEdits& EditBatch::get_chunk_edits(int chunk_x, int chunk_y, int chunk_z)
+{
+	// Consecutive edits nearly always fall in the same chunk
+	if (m_last_chunk_edit_index < m_chunk_edits.size())
+	{
+		auto& last = m_chunk_edits[m_last_chunk_edit_index];
+
+		if (last.chunk_x == chunk_x && last.chunk_y == chunk_y && last.chunk_z == chunk_z)
+		{
+			return last;
+		}
+	}
+
+	auto result = m_chunk_edit_indices.emplace(std::make_tuple(chunk_x, chunk_y, chunk_z), m_chunk_edits.size());
+
+	if (result.second)
+	{
+		m_chunk_edits.push_back({chunk_x, chunk_y, chunk_z, {}, 0});
+	}
+
+	m_last_chunk_edit_index = result.first->second;
+
+	return m_chunk_edits[m_last_chunk_edit_index];
+}
\ No newline at end of file
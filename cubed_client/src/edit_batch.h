@@ -0,0 +1,69 @@
+#ifndef CUBED_EDIT_BATCH_H
+#define CUBED_EDIT_BATCH_H
+
+#include "block_type.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Collects block edits grouped by chunk so that World::edit_region can apply them with one
+// copy on write per chunk and invalidate every affected chunk only once.
+class EditBatch
+{
+public:
+	// Bits of ChunkEdits::boundary_faces
+	enum Face : std::uint8_t
+	{
+		FACE_NEG_X = 1,
+		FACE_POS_X = 2,
+		FACE_NEG_Y = 4,
+		FACE_POS_Y = 8,
+		FACE_NEG_Z = 16,
+		FACE_POS_Z = 32
+	};
+
+	struct BlockEdit
+	{
+		int x;
+		int y;
+		int z;
+		BlockType type;
+	};
+
+	struct ChunkEdits
+	{
+		int chunk_x;
+		int chunk_y;
+		int chunk_z;
+		std::vector<std::pair<int, BlockType>> blocks;
+
+		// Face bits set if an edited block lies on that face, in which case the neighbouring
+		// chunk's mesh is affected too.
+		std::uint8_t boundary_faces;
+	};
+
+	EditBatch();
+
+	void set_block(int x, int y, int z, BlockType type);
+
+	// Bounds are inclusive
+	void fill_box(int low_x, int low_y, int low_z, int high_x, int high_y, int high_z, BlockType type);
+	void fill_sphere(int center_x, int center_y, int center_z, int radius, BlockType type);
+	void paste(const std::vector<BlockEdit>& blocks, int offset_x, int offset_y, int offset_z);
+
+	const auto& get_chunk_edits() const { return m_chunk_edits; }
+	bool empty() const { return m_chunk_edits.empty(); }
+	void clear();
+
+private:
+	ChunkEdits& get_chunk_edits(int chunk_x, int chunk_y, int chunk_z);
+
+	std::vector<ChunkEdits> m_chunk_edits;
+	std::map<std::tuple<int, int, int>, std::size_t> m_chunk_edit_indices;
+	std::size_t m_last_chunk_edit_index;
+};
+
+#endif
\ No newline at end of file
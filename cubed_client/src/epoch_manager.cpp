@@ -0,0 +1,100 @@
+#include "epoch_manager.h"
+#include <algorithm>
+
+const int EpochManager::MAX_PARTICIPANTS;
+
+EpochManager::Guard::Guard(EpochManager& epochs, int participant) :
+	m_pinned_epoch(epochs.m_pinned_epochs[participant])
+{
+	m_pinned_epoch.store(epochs.m_epoch.load());
+
+	// The pin has to be visible to the owning thread before any shared pointer is loaded
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+EpochManager::Guard::~Guard()
+{
+	m_pinned_epoch.store(0, std::memory_order_release);
+}
+
+EpochManager::EpochManager() :
+	m_epoch{1}
+{
+	for (auto& pinned_epoch : m_pinned_epochs)
+	{
+		pinned_epoch = 0;
+	}
+
+	for (auto& participant : m_participants)
+	{
+		participant = false;
+	}
+}
+
+EpochManager::~EpochManager()
+{
+	for (auto& retired : m_retired)
+	{
+		retired.destroy(retired.object);
+	}
+}
+
+int EpochManager::add_participant()
+{
+	for (int i = 0; i < MAX_PARTICIPANTS; ++i)
+	{
+		bool in_use = false;
+
+		if (m_participants[i].compare_exchange_strong(in_use, true))
+		{
+			return i;
+		}
+	}
+
+	throw EpochManagerException("Too many epoch participants");
+}
+
+void EpochManager::remove_participant(int participant)
+{
+	m_pinned_epochs[participant] = 0;
+	m_participants[participant] = false;
+}
+
+void EpochManager::collect()
+{
+	// Pairs with the fence in Guard so that a reader either shows up as pinned here or can no
+	// longer find anything that was unpublished before this point.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	auto epoch = m_epoch.load();
+
+	bool readers_caught_up = std::all_of(m_pinned_epochs.begin(), m_pinned_epochs.end(), [epoch](const std::atomic<std::uint64_t>& pinned_epoch)
+	{
+		auto pinned = pinned_epoch.load();
+		return pinned == 0 || pinned == epoch;
+	});
+
+	if (readers_caught_up)
+	{
+		m_epoch = ++epoch;
+	}
+
+	// Readers pinned at the epoch an object was retired in may still be using it, but once the
+	// epoch has advanced twice all of them have unpinned.
+	auto first_alive = std::partition(m_retired.begin(), m_retired.end(), [epoch](const Retired& retired)
+	{
+		return retired.epoch + 2 <= epoch;
+	});
+
+	for (auto it = m_retired.begin(); it != first_alive; ++it)
+	{
+		it->destroy(it->object);
+	}
+
+	m_retired.erase(m_retired.begin(), first_alive);
+}
+
+void EpochManager::retire(void* object, void (*destroy)(void*))
+{
+	m_retired.push_back({m_epoch.load(), object, destroy});
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef CUBED_EPOCH_MANAGER_H
+#define CUBED_EPOCH_MANAGER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Epoch based deferred reclamation. A single owning thread unpublishes shared objects and
+// retires them instead of deleting them. Other threads pin the current epoch with a Guard while
+// they use pointers to shared objects, and a retired object is only deleted once every thread
+// that was pinned when it was retired has unpinned. Readers never block or take locks.
+class EpochManager
+{
+public:
+	class Guard
+	{
+	public:
+		Guard(EpochManager& epochs, int participant);
+		~Guard();
+
+		Guard(const Guard&) = delete;
+		Guard& operator=(const Guard&) = delete;
+
+	private:
+		std::atomic<std::uint64_t>& m_pinned_epoch;
+	};
+
+	EpochManager();
+	~EpochManager();
+
+	EpochManager(const EpochManager&) = delete;
+	EpochManager& operator=(const EpochManager&) = delete;
+
+	// Each reading thread registers once and passes its participant to the guards it creates
+	int add_participant();
+	void remove_participant(int participant);
+
+	// Deletes the object once no reader can still be using it. Only the owning thread may
+	// retire objects, and they must already be unreachable for new readers.
+	template<typename T>
+	void retire(std::unique_ptr<T> object)
+	{
+		retire(object.release(), [](void* retired) { delete static_cast<T*>(retired); });
+	}
+
+	// Advances the epoch if every pinned reader has seen the current one, then deletes the
+	// retired objects that are at least two epochs old. Only the owning thread may call this.
+	void collect();
+
+	auto get_num_retired() const { return m_retired.size(); }
+
+	static const int MAX_PARTICIPANTS = 16;
+
+private:
+	struct Retired
+	{
+		std::uint64_t epoch;
+		void* object;
+		void (*destroy)(void*);
+	};
+
+	void retire(void* object, void (*destroy)(void*));
+
+	std::atomic<std::uint64_t> m_epoch;
+
+	// The epoch each participant is pinned at, or zero if it isn't pinned. Epochs start at one.
+	std::array<std::atomic<std::uint64_t>, MAX_PARTICIPANTS> m_pinned_epochs;
+	std::array<std::atomic_bool, MAX_PARTICIPANTS> m_participants;
+	std::vector<Retired> m_retired;
+};
+
+#include "cubed_exception.h"
+#include <string>
+#include <utility>
+
+class EpochManagerException : public CubedException
+{
+public:
+	EpochManagerException(std::string message) : CubedException(std::move(message)) { }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef CUBED_FRUSTUM_H
+#define CUBED_FRUSTUM_H
+
+#include "axis_aligned_bounding_box.h"
+#include <glm/include/glm.hpp>
+
+// View frustum as six planes taken from a view projection matrix. Plane normals point inwards.
+class Frustum
+{
+public:
+	Frustum() :
+		Frustum(glm::mat4{1.0f})
+	{
+	}
+
+	Frustum(const glm::mat4& view_projection)
+	{
+		auto row = [&view_projection](int i) { return glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]); };
+
+		m_planes[0] = row(3) + row(0);
+		m_planes[1] = row(3) - row(0);
+		m_planes[2] = row(3) + row(1);
+		m_planes[3] = row(3) - row(1);
+		m_planes[4] = row(3) + row(2);
+		m_planes[5] = row(3) - row(2);
+	}
+
+	// Conservative: boxes near the corners of the frustum may be reported as intersecting it
+	// when they are just outside
+	bool intersects(const AxisAlignedBoundingBox& box) const
+	{
+		for (auto& plane : m_planes)
+		{
+			// The corner of the box furthest along the plane normal
+			glm::vec3 corner(plane.x >= 0.0f ? box.high.x : box.low.x, plane.y >= 0.0f ? box.high.y : box.low.y, plane.z >= 0.0f ? box.high.z : box.low.z);
+
+			if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+private:
+	glm::vec4 m_planes[6];
+};
+
+#endif
\ No newline at end of file
@@ -100,8 +100,10 @@ void Game::update(std::chrono::nanoseconds delta)
 		m_physical_object_manager.update(delta);
 	}
 
-	m_world.update(m_player.get_position());
-	m_rendering_engine.set_mat4("transform", m_rendering_engine.get_projection_matrix() * m_player.get_camera().get_matrix());
+	auto transform = m_rendering_engine.get_projection_matrix() * m_player.get_camera().get_matrix();
+
+	m_world.update(m_player.get_position(), m_player.get_velocity(), transform);
+	m_rendering_engine.set_mat4("transform", transform);
 	m_rendering_engine.update_uniforms();
 }
 
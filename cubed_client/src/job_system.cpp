@@ -0,0 +1,138 @@
+#include "job_system.h"
+#include <algorithm>
+#include <utility>
+
+JobSystem::JobSystem(int num_workers) :
+	m_next_worker{0},
+	m_num_queued{0},
+	m_stop{false}
+{
+	for (int i = 0; i < num_workers; ++i)
+	{
+		m_workers.push_back(std::make_unique<Worker>());
+	}
+
+	// Workers steal from each other, so they can only start once all of them exist
+	for (int i = 0; i < num_workers; ++i)
+	{
+		m_workers[i]->thread = std::thread{&JobSystem::run_worker, this, i};
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+		m_stop = true;
+	}
+
+	m_wake.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker->thread.join();
+	}
+}
+
+void JobSystem::submit(Job job)
+{
+	// Counting the job before it is queued means the count can run ahead of the queues but
+	// never behind them
+	{
+		std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+		++m_num_queued;
+	}
+
+	auto& worker = *m_workers[m_next_worker++ % m_workers.size()];
+
+	{
+		std::lock_guard<decltype(worker.mutex)> lock(worker.mutex);
+		worker.jobs.push_back(std::move(job));
+	}
+
+	m_wake.notify_one();
+}
+
+void JobSystem::submit_background(Job job)
+{
+	{
+		std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+		m_background_jobs.push_back(std::move(job));
+		++m_num_queued;
+	}
+
+	m_wake.notify_one();
+}
+
+int JobSystem::get_default_num_workers()
+{
+	return std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+}
+
+void JobSystem::run_worker(int index)
+{
+	Job job;
+
+	for (;;)
+	{
+		if (take_job(index, job))
+		{
+			job(index);
+			job = nullptr;
+			continue;
+		}
+
+		std::unique_lock<decltype(m_mutex)> lock(m_mutex);
+		m_wake.wait(lock, [this] { return m_stop || m_num_queued > 0; });
+
+		if (m_stop)
+		{
+			return;
+		}
+	}
+}
+
+bool JobSystem::take_job(int index, Job& job)
+{
+	auto num_workers = m_workers.size();
+
+	for (std::size_t i = 0; i < num_workers; ++i)
+	{
+		auto& worker = *m_workers[(index + i) % num_workers];
+		std::lock_guard<decltype(worker.mutex)> lock(worker.mutex);
+
+		if (worker.jobs.empty())
+		{
+			continue;
+		}
+
+		// Callers submit the most important jobs first, so a worker's own queue is run oldest
+		// first. Stolen jobs are taken from the other end, leaving the owner's next job alone.
+		if (i == 0)
+		{
+			job = std::move(worker.jobs.front());
+			worker.jobs.pop_front();
+		}
+		else
+		{
+			job = std::move(worker.jobs.back());
+			worker.jobs.pop_back();
+		}
+
+		--m_num_queued;
+		return true;
+	}
+
+	std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+
+	if (m_background_jobs.empty())
+	{
+		return false;
+	}
+
+	job = std::move(m_background_jobs.front());
+	m_background_jobs.pop_front();
+	--m_num_queued;
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef CUBED_JOB_SYSTEM_H
+#define CUBED_JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool of worker threads with a job queue each. Submitted jobs are spread across the queues.
+// Workers run their own queue in submission order, so jobs submitted in priority order keep
+// that order, and steal the newest job from the others when it runs dry, so the load evens out
+// without a single shared queue. Background jobs only run when no worker has anything else to
+// do. Idle workers sleep on a condition variable rather than spinning.
+class JobSystem
+{
+public:
+	// Jobs are passed the index of the worker running them
+	typedef std::function<void(int)> Job;
+
+	JobSystem(int num_workers);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Both can be called from any thread, including from inside a job
+	void submit(Job job);
+	void submit_background(Job job);
+
+	int get_num_workers() const { return static_cast<int>(m_workers.size()); }
+
+	// One worker per hardware thread, less one for the main thread
+	static int get_default_num_workers();
+
+private:
+	struct Worker
+	{
+		std::deque<Job> jobs;
+		std::mutex mutex;
+		std::thread thread;
+	};
+
+	void run_worker(int index);
+	bool take_job(int index, Job& job);
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::deque<Job> m_background_jobs;
+	std::atomic<unsigned int> m_next_worker;
+
+	// Counts queued jobs of both kinds. It is only incremented while holding m_mutex, so a
+	// worker can't miss a job between checking it and going to sleep.
+	std::atomic<std::size_t> m_num_queued;
+	bool m_stop;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "lz4.h"
+#include <array>
+#include <cstring>
+
+namespace LZ4
+{
+	const std::size_t MIN_MATCH = 4;
+	const std::size_t MAX_OFFSET = 65535;
+
+	// The format requires the last 5 bytes to be literals and the last match to start at
+	// least 12 bytes before the end of the input.
+	const std::size_t LAST_LITERALS = 5;
+	const std::size_t MATCH_SEARCH_LIMIT = 12;
+
+	const int HASH_BITS = 12;
+
+	namespace
+	{
+		std::uint32_t read_u32(const std::uint8_t* p)
+		{
+			std::uint32_t value;
+			std::memcpy(&value, p, sizeof(value));
+			return value;
+		}
+
+		std::uint32_t hash(std::uint32_t sequence) { return (sequence * 2654435761u) >> (32 - HASH_BITS); }
+
+		void write_length(std::vector<std::uint8_t>& dest, std::size_t length)
+		{
+			for (; length >= 255; length -= 255)
+			{
+				dest.push_back(255);
+			}
+
+			dest.push_back(static_cast<std::uint8_t>(length));
+		}
+
+		void write_sequence(std::vector<std::uint8_t>& dest, const std::uint8_t* literals, std::size_t num_literals, std::size_t offset, std::size_t match_length)
+		{
+			std::size_t extra_match_length = match_length >= MIN_MATCH ? match_length - MIN_MATCH : 0;
+
+			dest.push_back(static_cast<std::uint8_t>(((num_literals < 15 ? num_literals : 15) << 4) | (extra_match_length < 15 ? extra_match_length : 15)));
+
+			if (num_literals >= 15)
+			{
+				write_length(dest, num_literals - 15);
+			}
+
+			dest.insert(dest.end(), literals, literals + num_literals);
+
+			if (match_length == 0)
+			{
+				return;
+			}
+
+			dest.push_back(static_cast<std::uint8_t>(offset & 0xff));
+			dest.push_back(static_cast<std::uint8_t>(offset >> 8));
+
+			if (extra_match_length >= 15)
+			{
+				write_length(dest, extra_match_length - 15);
+			}
+		}
+	}
+
+	std::vector<std::uint8_t> compress(const std::uint8_t* source, std::size_t source_size)
+	{
+		std::vector<std::uint8_t> dest;
+		dest.reserve(source_size / 2);
+
+		std::array<std::size_t, 1 << HASH_BITS> table;
+		table.fill(SIZE_MAX);
+
+		std::size_t anchor = 0;
+		std::size_t pos = 0;
+
+		if (source_size > MATCH_SEARCH_LIMIT)
+		{
+			std::size_t match_limit = source_size - MATCH_SEARCH_LIMIT;
+
+			while (pos < match_limit)
+			{
+				auto sequence = read_u32(source + pos);
+				auto& entry = table[hash(sequence)];
+				auto candidate = entry;
+				entry = pos;
+
+				if (candidate == SIZE_MAX || pos - candidate > MAX_OFFSET || read_u32(source + candidate) != sequence)
+				{
+					++pos;
+					continue;
+				}
+
+				std::size_t match_length = MIN_MATCH;
+
+				while (pos + match_length < source_size - LAST_LITERALS && source[candidate + match_length] == source[pos + match_length])
+				{
+					++match_length;
+				}
+
+				write_sequence(dest, source + anchor, pos - anchor, pos - candidate, match_length);
+
+				pos += match_length;
+				anchor = pos;
+			}
+		}
+
+		write_sequence(dest, source + anchor, source_size - anchor, 0, 0);
+		dest.shrink_to_fit();
+
+		return dest;
+	}
+
+	bool decompress(const std::uint8_t* source, std::size_t source_size, std::uint8_t* dest, std::size_t dest_size)
+	{
+		std::size_t in = 0;
+		std::size_t out = 0;
+
+		auto read_length = [source, source_size, &in](std::size_t& length)
+		{
+			std::uint8_t byte;
+
+			do
+			{
+				if (in >= source_size)
+				{
+					return false;
+				}
+
+				byte = source[in++];
+				length += byte;
+			} while (byte == 255);
+
+			return true;
+		};
+
+		while (in < source_size)
+		{
+			auto token = source[in++];
+			std::size_t num_literals = token >> 4;
+
+			if (num_literals == 15 && !read_length(num_literals))
+			{
+				return false;
+			}
+
+			if (in + num_literals > source_size || out + num_literals > dest_size)
+			{
+				return false;
+			}
+
+			std::memcpy(dest + out, source + in, num_literals);
+			in += num_literals;
+			out += num_literals;
+
+			// The last sequence has no match
+			if (in == source_size)
+			{
+				break;
+			}
+
+			if (in + 2 > source_size)
+			{
+				return false;
+			}
+
+			std::size_t offset = source[in] | (source[in + 1] << 8);
+			in += 2;
+
+			std::size_t match_length = token & 15;
+
+			if (match_length == 15 && !read_length(match_length))
+			{
+				return false;
+			}
+
+			match_length += MIN_MATCH;
+
+			if (offset == 0 || offset > out || out + match_length > dest_size)
+			{
+				return false;
+			}
+
+			// Matches may overlap the output being written, so copy byte by byte
+			for (std::size_t i = 0; i < match_length; ++i, ++out)
+			{
+				dest[out] = dest[out - offset];
+			}
+		}
+
+		return out == dest_size;
+	}
+}
\ No newline at end of file
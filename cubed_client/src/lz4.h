@@ -0,0 +1,18 @@
+#ifndef CUBED_LZ4_H
+#define CUBED_LZ4_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Minimal implementation of the LZ4 block format, used for compressing cold chunk data.
+namespace LZ4
+{
+	std::vector<std::uint8_t> compress(const std::uint8_t* source, std::size_t source_size);
+
+	// Returns false if the compressed data is malformed or doesn't decompress to exactly
+	// dest_size bytes.
+	bool decompress(const std::uint8_t* source, std::size_t source_size, std::uint8_t* dest, std::size_t dest_size);
+}
+
+#endif
\ No newline at end of file
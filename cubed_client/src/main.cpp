@@ -1,14 +1,29 @@
+#include "benchmark.h"
 #include "game.h"
 #include <codecvt>
+#include <cstring>
 #include <exception>
+#include <fstream>
 #include <Windows.h>
 
 int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInstance, char* cmdLine, int nCmdShow)
 {
 	try
 	{
-		Game g;
-		g.run();
+		// The benchmark runs instead of the game and writes its report to the working directory
+		if (std::strstr(cmdLine, "-benchmark"))
+		{
+			std::ofstream report{"benchmark.txt"};
+			Benchmark benchmark;
+			benchmark.run(report);
+
+			MessageBox(0, L"Report written to benchmark.txt", L"Benchmark", MB_OK | MB_ICONINFORMATION);
+		}
+		else
+		{
+			Game g;
+			g.run();
+		}
 	}
 	catch (const std::exception& e)
 	{
@@ -4,13 +4,14 @@ MeshPTI::MeshPTI(bool dynamic) :
 	m_dynamic(dynamic),
 	m_num_vertices(0),
 	m_num_indices(0),
+	m_index_type(GL_UNSIGNED_SHORT),
 	m_vbo(false),
 	m_vao(false)
 {
 }
 
 MeshPTI::MeshPTI(VertexPT vertices[], unsigned short indices[], GLsizei numVertices,	GLsizei numIndices, bool dynamic)
-	: m_dynamic(dynamic), m_num_vertices(0), m_num_indices(0), m_vbo(false), m_vao(true)
+	: m_dynamic(dynamic), m_num_vertices(0), m_num_indices(0), m_index_type(GL_UNSIGNED_SHORT), m_vbo(false), m_vao(true)
 {
 	glGenVertexArrays(1, m_vertex_arrays);
 	set_data(vertices, indices, numVertices, numIndices);
@@ -34,11 +35,21 @@ void MeshPTI::render() const
 	if(m_num_indices > 0)
 	{
 		glBindVertexArray(m_vertex_arrays[0]);
-		glDrawElements(GL_TRIANGLES, m_num_indices, GL_UNSIGNED_SHORT, 0);
+		glDrawElements(GL_TRIANGLES, m_num_indices, m_index_type, 0);
 	}
 }
 
 void MeshPTI::set_data(const VertexPT vertices[], const unsigned short indices[], GLsizei numVertices, GLsizei numIndices)
+{
+	set_data(vertices, indices, sizeof(indices[0]), GL_UNSIGNED_SHORT, numVertices, numIndices);
+}
+
+void MeshPTI::set_data(const VertexPT vertices[], const unsigned int indices[], GLsizei numVertices, GLsizei numIndices)
+{
+	set_data(vertices, indices, sizeof(indices[0]), GL_UNSIGNED_INT, numVertices, numIndices);
+}
+
+void MeshPTI::set_data(const VertexPT vertices[], const void* indices, GLsizeiptr indexSize, GLenum indexType, GLsizei numVertices, GLsizei numIndices)
 {
 	if(!m_vao)
 	{
@@ -68,15 +79,20 @@ void MeshPTI::set_data(const VertexPT vertices[], const unsigned short indices[]
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffers[INDEX_BUFFER]);
 	
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices[0]) * numIndices, indices, m_dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize * numIndices, indices, m_dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
 
 	m_num_vertices = numVertices;
 	m_num_indices = numIndices;
+	m_index_type = indexType;
 }
 
 void MeshPTI::clear_data()
 {
-	glDeleteBuffers(NUM_BUFFERS, m_buffers);
+	if(m_vbo)
+	{
+		glDeleteBuffers(NUM_BUFFERS, m_buffers);
+	}
+
 	m_num_vertices = 0;
 	m_num_indices = 0;
 	m_vbo = false;
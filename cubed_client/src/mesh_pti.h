@@ -26,9 +26,12 @@ public:
 	void render() const;
 
 	void set_data(const VertexPT vertices[], const unsigned short indices[], GLsizei num_vertices, GLsizei num_indices);
+	void set_data(const VertexPT vertices[], const unsigned int indices[], GLsizei num_vertices, GLsizei num_indices);
 	void clear_data();
 
 private:
+	void set_data(const VertexPT vertices[], const void* indices, GLsizeiptr index_size, GLenum index_type, GLsizei num_vertices, GLsizei num_indices);
+
 	enum
 	{
 		VERTEX_BUFFER,
@@ -40,6 +43,7 @@ private:
 	GLuint m_buffers[NUM_BUFFERS];
 	GLsizei m_num_vertices;
 	GLsizei m_num_indices;
+	GLenum m_index_type;
 	bool m_dynamic;
 	bool m_vbo;
 	bool m_vao;
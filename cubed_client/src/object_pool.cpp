@@ -0,0 +1,257 @@
+#include "object_pool.h"
+#include <algorithm>
+
+#ifdef CUBED_HUGE_PAGES
+	#ifdef _WIN32
+		#include <Windows.h>
+	#else
+		#include <sys/mman.h>
+	#endif
+#endif
+
+namespace
+{
+	// allocate_huge_pages returns null if huge pages aren't available, for example because the
+	// process lacks the privilege to lock pages in memory on Windows or none are reserved on
+	// Linux
+#if defined(CUBED_HUGE_PAGES) && defined(_WIN32)
+	void* allocate_huge_pages(std::size_t size)
+	{
+		auto large_page_size = GetLargePageMinimum();
+
+		if (large_page_size == 0 || size % large_page_size != 0)
+		{
+			return nullptr;
+		}
+
+		return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+	}
+
+	void free_huge_pages(void* memory, std::size_t) { VirtualFree(memory, 0, MEM_RELEASE); }
+#elif defined(CUBED_HUGE_PAGES)
+	void* allocate_huge_pages(std::size_t size)
+	{
+		auto memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		return memory == MAP_FAILED ? nullptr : memory;
+	}
+
+	void free_huge_pages(void* memory, std::size_t size) { munmap(memory, size); }
+#else
+	void* allocate_huge_pages(std::size_t) { return nullptr; }
+	void free_huge_pages(void*, std::size_t) { }
+#endif
+
+	std::size_t round_up(std::size_t size, std::size_t alignment) { return (size + alignment - 1) / alignment * alignment; }
+}
+
+ObjectPool::ObjectPool() :
+	m_object_size{0},
+	m_free{nullptr},
+	m_in_use{0},
+	m_allocations{0},
+	m_fallback_allocations{0},
+	m_huge_pages{false}
+{
+}
+
+ObjectPool::~ObjectPool()
+{
+	for (auto slab : m_slabs)
+	{
+		if (m_huge_pages)
+		{
+			free_huge_pages(slab, SLAB_SIZE);
+		}
+		else
+		{
+			::operator delete(slab);
+		}
+	}
+}
+
+void* ObjectPool::allocate(std::size_t size)
+{
+	std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+
+	if (m_object_size == 0)
+	{
+		m_object_size = round_up(std::max(size, sizeof(FreeObject)), alignof(std::max_align_t));
+	}
+
+	if (!is_pooled(size))
+	{
+		++m_fallback_allocations;
+		return ::operator new(size);
+	}
+
+	if (!m_free)
+	{
+		add_slab();
+	}
+
+	auto object = m_free;
+	m_free = object->next;
+
+	++m_in_use;
+	++m_allocations;
+
+	return object;
+}
+
+void ObjectPool::deallocate(void* object, std::size_t size)
+{
+	if (!is_pooled(size))
+	{
+		::operator delete(object);
+		return;
+	}
+
+	std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+
+	auto free_object = static_cast<FreeObject*>(object);
+	free_object->next = m_free;
+	m_free = free_object;
+
+	--m_in_use;
+}
+
+ObjectPool::Stats ObjectPool::get_stats() const
+{
+	std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+
+	auto objects_per_slab = m_object_size == 0 ? 0 : SLAB_SIZE / m_object_size;
+	return {m_object_size, m_slabs.size(), m_slabs.size() * objects_per_slab, m_in_use, m_allocations, m_fallback_allocations, m_huge_pages};
+}
+
+void ObjectPool::add_slab()
+{
+	// Either every slab uses huge pages or none do, so they can be freed the same way
+	void* slab = m_slabs.empty() || m_huge_pages ? allocate_huge_pages(SLAB_SIZE) : nullptr;
+
+	if (m_slabs.empty())
+	{
+		m_huge_pages = slab != nullptr;
+	}
+
+	if (!slab)
+	{
+		if (m_huge_pages)
+		{
+			throw std::bad_alloc();
+		}
+
+		slab = ::operator new(SLAB_SIZE);
+	}
+
+	m_slabs.push_back(slab);
+
+	auto objects = static_cast<char*>(slab);
+
+	for (std::size_t offset = 0; offset + m_object_size <= SLAB_SIZE; offset += m_object_size)
+	{
+		auto free_object = reinterpret_cast<FreeObject*>(objects + offset);
+		free_object->next = m_free;
+		m_free = free_object;
+	}
+}
+
+WordBufferPool::WordBufferPool(std::size_t max_per_size) :
+	m_max_per_size{max_per_size},
+	m_held{0},
+	m_reused{0},
+	m_allocated{0}
+{
+}
+
+void WordBufferPool::assign(Buffer& buffer, std::size_t size, std::uint64_t value)
+{
+	reserve(buffer, size);
+	buffer.assign(size, value);
+}
+
+void WordBufferPool::assign(Buffer& buffer, const Buffer& other)
+{
+	reserve(buffer, other.size());
+	buffer.assign(other.begin(), other.end());
+}
+
+void WordBufferPool::release(Buffer& buffer)
+{
+	if (buffer.capacity() == 0)
+	{
+		return;
+	}
+
+	Buffer freed;
+
+	{
+		std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+		auto& bin = get_bin(buffer.capacity());
+
+		if (bin.buffers.size() < m_max_per_size)
+		{
+			bin.buffers.push_back(std::move(buffer));
+			++m_held;
+		}
+		else
+		{
+			freed.swap(buffer);
+		}
+	}
+
+	// Moved from vectors are empty in practice, but the standard doesn't promise it
+	buffer.clear();
+}
+
+WordBufferPool::Stats WordBufferPool::get_stats() const
+{
+	std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+	return {m_held, m_reused, m_allocated};
+}
+
+void WordBufferPool::reserve(Buffer& buffer, std::size_t size)
+{
+	if (buffer.capacity() == size)
+	{
+		return;
+	}
+
+	release(buffer);
+
+	if (size == 0)
+	{
+		return;
+	}
+
+	std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+	auto& bin = get_bin(size);
+
+	if (bin.buffers.empty())
+	{
+		++m_allocated;
+		buffer.reserve(size);
+		return;
+	}
+
+	buffer.swap(bin.buffers.back());
+	bin.buffers.pop_back();
+	--m_held;
+	++m_reused;
+}
+
+WordBufferPool::Bin& WordBufferPool::get_bin(std::size_t size)
+{
+	for (auto& bin : m_bins)
+	{
+		if (bin.size == size)
+		{
+			return bin;
+		}
+	}
+
+	// Reserving the whole bin up front means returning a buffer never allocates
+	m_bins.push_back({size, {}});
+	m_bins.back().buffers.reserve(m_max_per_size);
+
+	return m_bins.back();
+}
\ No newline at end of file
@@ -0,0 +1,150 @@
+#ifndef CUBED_OBJECT_POOL_H
+#define CUBED_OBJECT_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Fixed size object allocator. Memory is taken from the system in large slabs that are never
+// returned until the pool is destroyed, and freed objects are recycled through a free list, so
+// once a pool has grown to its working set it doesn't call the system allocator at all.
+//
+// The object size is fixed by the first allocation. Larger requests, and objects too big to fit
+// in a slab, fall back to the global allocator. Define CUBED_HUGE_PAGES to back slabs with huge
+// pages where the system allows it.
+class ObjectPool
+{
+public:
+	struct Stats
+	{
+		std::size_t object_size;
+		std::size_t slabs;
+		std::size_t capacity;
+		std::size_t in_use;
+		unsigned long long allocations;
+		unsigned long long fallback_allocations;
+		bool huge_pages;
+	};
+
+	ObjectPool();
+	~ObjectPool();
+
+	ObjectPool(const ObjectPool&) = delete;
+	ObjectPool& operator=(const ObjectPool&) = delete;
+
+	void* allocate(std::size_t size);
+	void deallocate(void* object, std::size_t size);
+
+	Stats get_stats() const;
+
+	static const std::size_t SLAB_SIZE = 2 * 1024 * 1024;
+
+private:
+	struct FreeObject
+	{
+		FreeObject* next;
+	};
+
+	bool is_pooled(std::size_t size) const { return size <= m_object_size && m_object_size <= SLAB_SIZE; }
+	void add_slab();
+
+	std::size_t m_object_size;
+	FreeObject* m_free;
+	std::vector<void*> m_slabs;
+	std::size_t m_in_use;
+	unsigned long long m_allocations;
+	unsigned long long m_fallback_allocations;
+	bool m_huge_pages;
+	mutable std::mutex m_mutex;
+};
+
+// Standard allocator that allocates single objects from a pool, for use with allocate_shared
+template<typename T>
+class PoolAllocator
+{
+public:
+	typedef T value_type;
+
+	PoolAllocator(ObjectPool& pool) : m_pool(&pool) { }
+
+	template<typename U>
+	PoolAllocator(const PoolAllocator<U>& other) : m_pool(other.get_pool()) { }
+
+	T* allocate(std::size_t n) { return static_cast<T*>(n == 1 ? m_pool->allocate(sizeof(T)) : ::operator new(n * sizeof(T))); }
+
+	void deallocate(T* object, std::size_t n)
+	{
+		if (n == 1)
+		{
+			m_pool->deallocate(object, sizeof(T));
+		}
+		else
+		{
+			::operator delete(object);
+		}
+	}
+
+	ObjectPool* get_pool() const { return m_pool; }
+
+private:
+	ObjectPool* m_pool;
+};
+
+template<typename T, typename U>
+bool operator==(const PoolAllocator<T>& a, const PoolAllocator<U>& b) { return a.get_pool() == b.get_pool(); }
+
+template<typename T, typename U>
+bool operator!=(const PoolAllocator<T>& a, const PoolAllocator<U>& b) { return a.get_pool() != b.get_pool(); }
+
+// Recycles variable length arrays of 64 bit words. The arrays that hold block indices and masks
+// only come in a handful of lengths, so freed arrays are kept in a bin per length and handed out
+// again rather than going back to the system allocator. Each bin holds a bounded number of
+// arrays, and arrays beyond that are freed.
+class WordBufferPool
+{
+public:
+	typedef std::vector<std::uint64_t> Buffer;
+
+	struct Stats
+	{
+		std::size_t held;
+		unsigned long long reused;
+		unsigned long long allocated;
+	};
+
+	WordBufferPool(std::size_t max_per_size);
+
+	WordBufferPool(const WordBufferPool&) = delete;
+	WordBufferPool& operator=(const WordBufferPool&) = delete;
+
+	// Replaces the buffer's contents with size copies of value. The buffer keeps its own array if
+	// it is already the right size, and otherwise swaps it for one of the right size.
+	void assign(Buffer& buffer, std::size_t size, std::uint64_t value);
+	void assign(Buffer& buffer, const Buffer& other);
+
+	// Takes the buffer's array for reuse and leaves the buffer empty
+	void release(Buffer& buffer);
+
+	Stats get_stats() const;
+
+private:
+	struct Bin
+	{
+		std::size_t size;
+		std::vector<Buffer> buffers;
+	};
+
+	void reserve(Buffer& buffer, std::size_t size);
+	Bin& get_bin(std::size_t size);
+
+	std::vector<Bin> m_bins;
+	std::size_t m_max_per_size;
+	std::size_t m_held;
+	unsigned long long m_reused;
+	unsigned long long m_allocated;
+	mutable std::mutex m_mutex;
+};
+
+#endif
\ No newline at end of file
@@ -56,18 +56,12 @@ void PhysicalObjectManager::update(std::chrono::nanoseconds delta)
 
 std::pair<bool, std::tuple<int, int, int>> PhysicalObjectManager::colliding_with_world(const AxisAlignedBoundingBox& aabb)
 {
-	for (int x = static_cast<int>(aabb.low.x); x <= static_cast<int>(aabb.high.x); ++x)
+	int x, y, z;
+
+	if (m_world.find_solid_block(static_cast<int>(aabb.low.x), static_cast<int>(aabb.low.y), static_cast<int>(aabb.low.z),
+		static_cast<int>(aabb.high.x), static_cast<int>(aabb.high.y), static_cast<int>(aabb.high.z), x, y, z))
 	{
-		for (int y = static_cast<int>(aabb.low.y); y <= static_cast<int>(aabb.high.y); ++y)
-		{
-			for (int z = static_cast<int>(aabb.low.z); z <= static_cast<int>(aabb.high.z); ++z)
-			{
-				if (m_world.is_block_at(x, y, z))
-				{
-					return std::make_pair(true, std::make_tuple(x, y, z));
-				}
-			}
-		}
+		return std::make_pair(true, std::make_tuple(x, y, z));
 	}
 
 	return std::make_pair(false, std::tuple<int, int, int>());
@@ -17,6 +17,7 @@ public:
 	void update(std::chrono::nanoseconds delta);
 
 	const glm::vec3& get_position() const { return m_position; }
+	const glm::vec3& get_velocity() const { return m_velocity; }
 	const Camera& get_camera() { return m_camera; }
 
 private:
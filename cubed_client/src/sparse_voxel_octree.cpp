@@ -0,0 +1,154 @@
+#include "chunk.h"
+#include "sparse_voxel_octree.h"
+#include <utility>
+#include <vector>
+
+SparseVoxelOctree::SparseVoxelOctree() :
+	m_root{BLOCK_AIR, nullptr}
+{
+}
+
+SparseVoxelOctree::Node SparseVoxelOctree::build_chunk(const BlockData& block_data)
+{
+	Node chunk{BLOCK_AIR, nullptr};
+
+	if (block_data.is_uniform())
+	{
+		chunk.type = block_data.get_uniform_type();
+	}
+	else
+	{
+		auto& blocks = BlockData::get_scratch_array();
+		block_data.get_all(blocks);
+		build(chunk, blocks, 0, 0, 0, WorldConstants::CHUNK_SIZE);
+	}
+
+	return chunk;
+}
+
+void SparseVoxelOctree::set_chunk(int chunk_x, int chunk_y, int chunk_z, Node chunk)
+{
+	int x = chunk_x * WorldConstants::CHUNK_SIZE;
+	int y = chunk_y * WorldConstants::CHUNK_SIZE;
+	int z = chunk_z * WorldConstants::CHUNK_SIZE;
+
+	// Walk down to the node covering the chunk, splitting leaves on the way and remembering the
+	// path so it can be collapsed again afterwards.
+	std::vector<Node*> path;
+	auto node = &m_root;
+
+	for (int size = REGION_SIZE; size > WorldConstants::CHUNK_SIZE; size /= 2)
+	{
+		if (!node->children)
+		{
+			split(*node);
+		}
+
+		path.push_back(node);
+
+		int half_size = size / 2;
+		node = &(*node->children)[get_child_index(x, y, z, half_size)];
+
+		x %= half_size;
+		y %= half_size;
+		z %= half_size;
+	}
+
+	*node = std::move(chunk);
+
+	for (auto it = path.rbegin(); it != path.rend(); ++it)
+	{
+		collapse(**it);
+	}
+
+	m_chunks[get_chunk_index(chunk_x, chunk_y, chunk_z)] = true;
+}
+
+BlockType SparseVoxelOctree::get_block_type(int x, int y, int z, int lod) const
+{
+	auto node = &m_root;
+	int lod_size = 1 << lod;
+
+	for (int size = REGION_SIZE; node->children && size > lod_size; size /= 2)
+	{
+		int half_size = size / 2;
+		node = &(*node->children)[get_child_index(x, y, z, half_size)];
+
+		x %= half_size;
+		y %= half_size;
+		z %= half_size;
+	}
+
+	return node->type;
+}
+
+void SparseVoxelOctree::build(Node& node, const BlockData::BlockArray& blocks, int x, int y, int z, int size)
+{
+	if (size == 1)
+	{
+		node.type = blocks[Chunk::get_block_index(x, y, z)];
+		return;
+	}
+
+	int half_size = size / 2;
+	node.children = std::make_unique<std::array<Node, 8>>();
+
+	for (int i = 0; i < 8; ++i)
+	{
+		build((*node.children)[i], blocks,
+			x + ((i & 4) ? half_size : 0), y + ((i & 2) ? half_size : 0), z + ((i & 1) ? half_size : 0), half_size);
+	}
+
+	collapse(node);
+}
+
+void SparseVoxelOctree::split(Node& node)
+{
+	node.children = std::make_unique<std::array<Node, 8>>();
+
+	for (auto& child : *node.children)
+	{
+		child.type = node.type;
+	}
+}
+
+void SparseVoxelOctree::collapse(Node& node)
+{
+	std::array<int, NUM_BLOCK_TYPES> counts{};
+	bool homogeneous = true;
+
+	for (auto& child : *node.children)
+	{
+		++counts[child.type];
+
+		if (child.children || child.type != (*node.children)[0].type)
+		{
+			homogeneous = false;
+		}
+	}
+
+	if (homogeneous)
+	{
+		node.type = (*node.children)[0].type;
+		node.children.reset();
+		return;
+	}
+
+	// The representative type is the most common solid type if at least half of the children
+	// are solid, otherwise air.
+	node.type = BLOCK_AIR;
+
+	if (8 - counts[BLOCK_AIR] >= 4)
+	{
+		int best_count = 0;
+
+		for (int type = 0; type < NUM_BLOCK_TYPES; ++type)
+		{
+			if (type != BLOCK_AIR && counts[type] > best_count)
+			{
+				best_count = counts[type];
+				node.type = static_cast<BlockType>(type);
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef CUBED_SPARSE_VOXEL_OCTREE_H
+#define CUBED_SPARSE_VOXEL_OCTREE_H
+
+#include "block_data.h"
+#include "block_type.h"
+#include "world_constants.h"
+#include <array>
+#include <bitset>
+#include <memory>
+
+// Read only block storage for a cube of REGION_CHUNKS^3 chunks. Homogeneous subtrees are
+// collapsed into a single leaf, so the mostly uniform chunks far away from the player cost a
+// handful of nodes instead of a dense block array each. Every interior node also stores a
+// representative block type, which allows coarse lookups for level of detail.
+class SparseVoxelOctree
+{
+public:
+	static const int REGION_CHUNKS = 4;
+	static const int REGION_SIZE = REGION_CHUNKS * WorldConstants::CHUNK_SIZE;
+
+	struct Node
+	{
+		BlockType type;
+		std::unique_ptr<std::array<Node, 8>> children;
+	};
+
+	SparseVoxelOctree();
+
+	// Builds the subtree for one chunk. It doesn't touch any region, so unlike the rest of the
+	// class it is safe to call from any thread.
+	static Node build_chunk(const BlockData& block_data);
+
+	void set_chunk(int chunk_x, int chunk_y, int chunk_z, Node chunk);
+	bool has_chunk(int chunk_x, int chunk_y, int chunk_z) const { return m_chunks[get_chunk_index(chunk_x, chunk_y, chunk_z)]; }
+
+	// Coordinates are relative to the region. A lod of n returns the representative type of
+	// the 2^n sized cube containing the block.
+	BlockType get_block_type(int x, int y, int z, int lod = 0) const;
+
+private:
+	static int get_chunk_index(int chunk_x, int chunk_y, int chunk_z) { return (chunk_x * REGION_CHUNKS + chunk_z) * REGION_CHUNKS + chunk_y; }
+	static int get_child_index(int x, int y, int z, int half_size) { return ((x >= half_size) << 2) | ((y >= half_size) << 1) | (z >= half_size); }
+
+	static void build(Node& node, const BlockData::BlockArray& blocks, int x, int y, int z, int size);
+	static void split(Node& node);
+	static void collapse(Node& node);
+
+	Node m_root;
+	std::bitset<REGION_CHUNKS * REGION_CHUNKS * REGION_CHUNKS> m_chunks;
+};
+
+#endif
\ No newline at end of file
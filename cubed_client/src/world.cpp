@@ -1,12 +1,101 @@
+#include "block_accessor.h"
 #include "chunk.h"
 #include "world.h"
 #include "world_constants.h"
 #include "world_gen/world_gen.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <utility>
+#include <vector>
+
+const float World::PREFETCH_SECONDS = 2.0f;
+const float World::MAX_PREFETCH_CHUNKS = 4.0f;
+const float World::MIN_PREFETCH_SPEED = 1.0f;
+const double World::DEFAULT_MESH_UPLOAD_BUDGET = 2.0;
+const double World::INITIAL_UPLOAD_NANOSECONDS_PER_BYTE = 1.0;
+const double World::UPLOAD_COST_SMOOTHING = 0.1;
+
+namespace
+{
+	int floor_div(int a, int b) { return (a < 0 ? a - b + 1 : a) / b; }
+
+	// Inverse of Chunk::get_coord_key for a single coordinate
+	int get_coord_from_key(std::uint64_t key, int shift)
+	{
+		auto field = static_cast<int>((key >> shift) & 0x1fffff);
+		return (field & 0x100000) ? field - 0x200000 : field;
+	}
+
+	// Inclusive box of chunk coordinates
+	struct ChunkBox
+	{
+		static ChunkBox around(int x, int y, int z, int radius) { return {x - radius, y - radius, z - radius, x + radius, y + radius, z + radius}; }
+		static ChunkBox empty() { return {0, 0, 0, -1, -1, -1}; }
+
+		bool contains(int x, int y, int z) const { return x >= low_x && x <= high_x && y >= low_y && y <= high_y && z >= low_z && z <= high_z; }
+
+		// Calls callback for every coordinate in this box that isn't in the other one. The
+		// callback is only called for the difference, but the x and y rows of this box are all
+		// walked to find it.
+		template<typename Callback>
+		void for_each_outside(const ChunkBox& other, Callback callback) const
+		{
+			for (int x = low_x; x <= high_x; ++x)
+			{
+				for (int y = low_y; y <= high_y; ++y)
+				{
+					bool row_overlaps = x >= other.low_x && x <= other.high_x && y >= other.low_y && y <= other.high_y;
+
+					for (int z = low_z; z <= high_z; ++z)
+					{
+						// Skip straight past the part of the row inside the other box
+						if (row_overlaps && z == std::max(low_z, other.low_z) && z <= other.high_z)
+						{
+							z = other.high_z;
+							continue;
+						}
+
+						callback(x, y, z);
+					}
+				}
+			}
+		}
+
+		int low_x;
+		int low_y;
+		int low_z;
+		int high_x;
+		int high_y;
+		int high_z;
+	};
+}
 
 World::World(int render_distance) :
 	m_render_distance{render_distance},
-	m_run_chunk_updates{true}
+	m_center_x{0},
+	m_center_y{0},
+	m_center_z{0},
+	m_reload_chunks{true},
+	m_chunks{render_distance + UNLOAD_DISTANCE_MARGIN, m_epochs},
+	m_far_field_distance{render_distance * 4},
+	m_chunk_cache{CHUNK_CACHE_CAPACITY},
+	m_cache_chunk_meshes{true},
+	m_num_running_updates{0},
+	m_updates_skipped{0},
+	m_updates_aborted{0},
+	m_updates_discarded{0},
+	m_num_generations{0},
+	m_num_meshes{0},
+	m_num_prefetches{0},
+	m_prefetch_stats{},
+	m_mesh_upload_budget{DEFAULT_MESH_UPLOAD_BUDGET},
+	m_upload_nanoseconds_per_byte{INITIAL_UPLOAD_NANOSECONDS_PER_BYTE},
+	m_last_upload_milliseconds{0.0},
+	m_last_cold_check{std::chrono::steady_clock::now()},
+	m_last_decompressions{BlockData::get_total_decompressions()},
+	m_decompressions_per_second{0.0},
+	m_jobs{std::min(JobSystem::get_default_num_workers(), EpochManager::MAX_PARTICIPANTS)}
 {
 	ChunkUpdate::set_world(this);
 	update_loaded_chunks(WorldGen::get_spawn_pos());
@@ -14,92 +103,123 @@ World::World(int render_distance) :
 	// pre-generate world
 	for_each_chunk([](Chunk* chunk, int x, int y, int z)
 	{
-		WorldGen::fill_chunk(*chunk->get_block_data(), x * WorldConstants::CHUNK_SIZE, y * WorldConstants::CHUNK_SIZE, z * WorldConstants::CHUNK_SIZE);
-		chunk->set_filled(true);
+		auto block_data = BlockData::create();
+		WorldGen::fill_chunk(*block_data, x * WorldConstants::CHUNK_SIZE, y * WorldConstants::CHUNK_SIZE, z * WorldConstants::CHUNK_SIZE);
+		chunk->set_block_data(std::move(block_data));
+		chunk->set_generated();
 		return true;
 	}, false);
 
-	m_chunk_update_thread = std::thread{std::bind(&World::chunk_update_thread, this)};
+	for (int i = 0; i < m_jobs.get_num_workers(); ++i)
+	{
+		m_worker_participants.push_back(m_epochs.add_participant());
+	}
 }
 
 World::~World()
 {
-	m_run_chunk_updates = false;
-
-	if (m_chunk_update_thread.joinable())
-	{
-		m_chunk_update_thread.join();
-	}
 }
 
-void World::update(const glm::vec3& center)
+void World::update(const glm::vec3& center, const glm::vec3& velocity, const glm::mat4& view_projection)
 {
 	update_loaded_chunks(center);
+	process_completed_compressions();
+	process_completed_far_field_chunks();
 
-	for_each_chunk([this](Chunk* chunk, int x, int y, int z)
+	auto now = std::chrono::steady_clock::now();
+
+	if (now - m_last_cold_check >= std::chrono::seconds{1})
+	{
+		queue_cold_chunk_compressions(now);
+	}
+
+	// Workers hand finished updates back through the completion queue, so only updates that
+	// have actually finished are looked at. Generated blocks are installed straight away, since
+	// that is cheap and lets neighbours waiting on them be meshed this frame. Meshes wait their
+	// turn to be uploaded.
+	m_completion_queue.drain([this](ChunkUpdate* chunk_update)
 	{
-		if (!chunk->update_queued() && (!chunk->filled() || !chunk->up_to_date()))
+		if (chunk_update->is_prefetch())
+		{
+			--m_num_prefetches;
+		}
+		else if (chunk_update->is_fill())
 		{
-			auto chunk_update_slot = get_chunk_update_slot(chunk->low_priority_update());
+			--m_num_running_updates;
+		}
 
-			if (!chunk_update_slot)
-			{
-				// No free slots. End the for_each_chunk loop.
-				return false;
-			}
+		if (chunk_update->is_fill())
+		{
+			process_completed_chunk_update(chunk_update);
+			recycle_chunk_update(chunk_update);
+		}
+		else
+		{
+			m_completed_chunk_updates.push_back(chunk_update);
+		}
+	});
 
-			auto chunk_update = std::make_unique<ChunkUpdate>(chunk->get_block_data(), x, y, z, !chunk->filled());
+	upload_meshes();
 
-			{
-				std::lock_guard<decltype(chunk_update_slot->second)> chunk_update_lock(chunk_update_slot->second);
-				chunk_update_slot->first = std::move(chunk_update);
-			}
+	// Every chunk that needs an update is queued by priority each frame, so the order follows
+	// the camera. Only a few updates per worker are in flight at once, so the rest stay in the
+	// queue and can still be overtaken by chunks that come into view.
+	m_update_queue.clear();
+	m_update_queue.set_view(center, view_projection);
 
-			chunk->set_update_queued(true);
+	for (auto chunk = m_dirty_chunks.get_front(); chunk;)
+	{
+		auto next = DirtyChunkList::get_next(chunk);
+
+		// Generated chunks waiting on a neighbour leave the list until the neighbour is generated
+		if (chunk->needs_update() && (chunk->get_stage() == Chunk::EMPTY || neighbours_generated(*chunk)))
+		{
+			m_update_queue.push(chunk);
+		}
+		else
+		{
+			m_dirty_chunks.remove(chunk);
 		}
 
-		return true;
-	}, false);
+		chunk = next;
+	}
 
-	// Limit to prevent stuttering
-	int mesh_updates = MAX_CHUNK_MESH_UPDATES_PER_FRAME;
+	auto max_running_updates = static_cast<std::size_t>(m_jobs.get_num_workers() * MAX_RUNNING_UPDATES_PER_WORKER);
 
-	auto process_completed_chunk_updates = [this, &mesh_updates](ChunkUpdateArray& chunk_updates)
+	while (m_num_running_updates < max_running_updates && !m_update_queue.empty())
 	{
-		for (auto& chunk_update : chunk_updates)
-		{
-			if (chunk_update.first && chunk_update.first->finished())
-			{
-				process_completed_chunk_update(chunk_update.first);
+		auto chunk = m_update_queue.pop();
 
-				{
-					std::lock_guard<decltype(chunk_update.second)> chunk_update_lock(chunk_update.second);
-					chunk_update.first.reset();
-				}
+		auto chunk_update = create_chunk_update(*chunk);
+		submit_chunk_update(chunk_update);
+		++m_num_running_updates;
 
-				if (--mesh_updates <= 0)
-				{
-					break;
-				}
-			}
-		}
-	};
+		m_dirty_chunks.remove(chunk);
+		chunk->begin_update(&chunk_update->get_cancellation_token());
+	}
 
-	process_completed_chunk_updates(m_chunk_updates);
+	prefetch_chunks(center, velocity);
 
-	if (mesh_updates > 0)
-	{
-		process_completed_chunk_updates(m_chunk_updates_low_priority);
-	}
+	m_epochs.collect();
 }
 
 void World::render()
 {
-	for_each_chunk([](Chunk* chunk, int x, int y, int z)
+	m_chunks.for_each([](Chunk* chunk)
 	{
 		chunk->render();
 		return true;
+	}, Chunk::FILLED | Chunk::HAS_MESH);
+}
+
+void World::set_render_distance(int render_distance)
+{
+	m_render_distance = render_distance;
+	m_chunks.resize(render_distance + UNLOAD_DISTANCE_MARGIN, m_center_x, m_center_y, m_center_z, [this](std::unique_ptr<Chunk> chunk)
+	{
+		unload_chunk(std::move(chunk));
 	});
+	m_reload_chunks = true;
 }
 
 BlockType World::get_block_type(int block_x, int block_y, int block_z) const
@@ -114,299 +234,758 @@ BlockType World::get_block_type(int block_x, int block_y, int block_z) const
 	return chunk->get_block_type(static_cast<int>(block_x - chunk->get_x() * WorldConstants::CHUNK_SIZE), static_cast<int>(block_y - chunk->get_y() * WorldConstants::CHUNK_SIZE), static_cast<int>(block_z - chunk->get_z() * WorldConstants::CHUNK_SIZE));
 }
 
-void World::chunk_update_thread()
+bool World::find_solid_block(int low_x, int low_y, int low_z, int high_x, int high_y, int high_z, int& block_x, int& block_y, int& block_z) const
 {
-	while (m_run_chunk_updates)
-	{
-		auto chunk_update = get_next_chunk_update();
+	BlockAccessor blocks{*this, low_x, low_y, low_z};
 
-		if (!chunk_update)
+	for (int x = low_x; x <= high_x; ++x)
+	{
+		for (int chunk_y = Chunk::get_chunk_coord(low_y); chunk_y <= Chunk::get_chunk_coord(high_y); ++chunk_y)
 		{
-			std::this_thread::yield();
-			continue;
-		}
+			int first_y = std::max(low_y - chunk_y * WorldConstants::CHUNK_SIZE, 0);
+			int last_y = std::min(high_y - chunk_y * WorldConstants::CHUNK_SIZE, WorldConstants::CHUNK_SIZE - 1);
+			auto y_mask = (BlockData::FULL_COLUMN >> (WorldConstants::CHUNK_SIZE - 1 - last_y)) & ~((std::uint64_t{1} << first_y) - 1);
+
+			// The lowest block in this layer of chunks wins, then the lowest z
+			int found_y = WorldConstants::CHUNK_SIZE;
+
+			for (int z = low_z; z <= high_z; ++z)
+			{
+				blocks.move_to(x, chunk_y * WorldConstants::CHUNK_SIZE + first_y, z);
+				auto column = blocks.get_solid_column() & y_mask;
 
-		chunk_update->first->run();
-		chunk_update->first->set_finished();
+				if (column && BlockData::get_lowest_bit(column) < found_y)
+				{
+					found_y = BlockData::get_lowest_bit(column);
+					block_z = z;
+				}
+			}
+
+			if (found_y < WorldConstants::CHUNK_SIZE)
+			{
+				block_x = x;
+				block_y = chunk_y * WorldConstants::CHUNK_SIZE + found_y;
+				return true;
+			}
+		}
 	}
+
+	return false;
 }
 
-void World::update_loaded_chunks(const glm::vec3& center)
+std::shared_ptr<const BlockData> World::get_chunk_block_data(int chunk_x, int chunk_y, int chunk_z) const
 {
-	int x = static_cast<int>((center.x < 0.0f) ? center.x - WorldConstants::CHUNK_SIZE - 1.0f : center.x);
-	int y = static_cast<int>((center.y < 0.0f) ? center.y - WorldConstants::CHUNK_SIZE - 1.0f : center.y);
-	int z = static_cast<int>((center.z < 0.0f) ? center.z - WorldConstants::CHUNK_SIZE - 1.0f : center.z);
+	auto chunk = get_chunk(chunk_x, chunk_y, chunk_z);
+	return chunk ? chunk->get_block_data() : nullptr;
+}
 
-	x /= WorldConstants::CHUNK_SIZE;
-	y /= WorldConstants::CHUNK_SIZE;
-	z /= WorldConstants::CHUNK_SIZE;
+void World::edit_region(const EditBatch& batch)
+{
+	std::vector<Chunk*> edited;
+	std::vector<Chunk*> neighbours;
 
-	int first_x = x - m_render_distance;
-	int first_y = y - m_render_distance;
-	int first_z = z - m_render_distance;
+	for (auto& chunk_edits : batch.get_chunk_edits())
+	{
+		auto chunk = get_chunk(chunk_edits.chunk_x, chunk_edits.chunk_y, chunk_edits.chunk_z);
 
-	int last_x = x + m_render_distance;
-	int last_y = y + m_render_distance;
-	int last_z = z + m_render_distance;
+		// Edits to chunks that aren't loaded or haven't been generated yet are dropped
+		if (!chunk || !chunk->filled())
+		{
+			continue;
+		}
 
-	for (x = first_x; x <= last_x; ++x)
-	{
-		for (y = first_y; y <= last_y; ++y)
+		chunk->set_block_types(chunk_edits.blocks);
+		edited.push_back(chunk);
+
+		auto add_neighbour = [this, &neighbours, &chunk_edits](EditBatch::Face face, int offset_x, int offset_y, int offset_z)
 		{
-			for (z = first_z; z <= last_z; ++z)
+			if (chunk_edits.boundary_faces & face)
 			{
-				if (!get_chunk(x, y, z))
-					load_chunk(x, y, z);
+				auto neighbour = get_chunk(chunk_edits.chunk_x + offset_x, chunk_edits.chunk_y + offset_y, chunk_edits.chunk_z + offset_z);
+
+				if (neighbour && neighbour->filled())
+				{
+					neighbours.push_back(neighbour);
+				}
 			}
-		}
+		};
+
+		add_neighbour(EditBatch::FACE_NEG_X, -1, 0, 0);
+		add_neighbour(EditBatch::FACE_POS_X, 1, 0, 0);
+		add_neighbour(EditBatch::FACE_NEG_Y, 0, -1, 0);
+		add_neighbour(EditBatch::FACE_POS_Y, 0, 1, 0);
+		add_neighbour(EditBatch::FACE_NEG_Z, 0, 0, -1);
+		add_neighbour(EditBatch::FACE_POS_Z, 0, 0, 1);
 	}
 
-	bool del_x = false;
-	bool del_y = false;
+	// Neighbours shared between several edited chunks, or edited themselves, are only
+	// invalidated once
+	std::sort(edited.begin(), edited.end());
+	std::sort(neighbours.begin(), neighbours.end());
+	neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
 
-	for (auto it_x = m_chunks.begin(); it_x != m_chunks.end();)
+	for (auto neighbour : neighbours)
 	{
-		for (auto it_y = it_x->second.begin(); it_y != it_x->second.end();)
+		if (!std::binary_search(edited.begin(), edited.end(), neighbour))
 		{
-			for (auto it_z = it_y->second.begin(); it_z != it_y->second.end();)
-			{
-				if ((it_z->second->get_x() < first_x) || (it_z->second->get_x() > last_x))
-				{
-					del_x = true;
+			neighbour->invalidate();
+		}
+	}
+}
 
-					break;
-				}
+BlockType World::get_far_block_type(int block_x, int block_y, int block_z, int lod) const
+{
+	int chunk_x = Chunk::get_chunk_coord(block_x);
+	int chunk_y = Chunk::get_chunk_coord(block_y);
+	int chunk_z = Chunk::get_chunk_coord(block_z);
 
-				if ((it_z->second->get_y() < first_y) || (it_z->second->get_y() > last_y))
-				{
-					del_y = true;
+	int local_x = block_x - chunk_x * WorldConstants::CHUNK_SIZE;
+	int local_y = block_y - chunk_y * WorldConstants::CHUNK_SIZE;
+	int local_z = block_z - chunk_z * WorldConstants::CHUNK_SIZE;
 
-					break;
-				}
+	// Unloaded chunks only reach the far field once they are evicted from the chunk cache
+	auto chunk = get_chunk(chunk_x, chunk_y, chunk_z);
 
-				if ((it_z->second->get_z() < first_z) || (it_z->second->get_z() > last_z))
-				{
-					it_z = it_y->second.erase(it_z);
-				}
-				else
-				{
-					++it_z;
-				}
-			}
+	if (!chunk)
+	{
+		chunk = m_chunk_cache.find(chunk_x, chunk_y, chunk_z);
+	}
 
-			if (del_x)
-			{
-				break;
-			}
-			else if (del_y)
+	if (chunk)
+	{
+		return chunk->get_block_type(local_x, local_y, local_z);
+	}
+
+	auto pending = m_far_field_pending.find(Chunk::get_coord_key(chunk_x, chunk_y, chunk_z));
+
+	if (pending != m_far_field_pending.end())
+	{
+		return pending->second->get(Chunk::get_block_index(local_x, local_y, local_z));
+	}
+
+	int region_x = floor_div(block_x, SparseVoxelOctree::REGION_SIZE);
+	int region_y = floor_div(block_y, SparseVoxelOctree::REGION_SIZE);
+	int region_z = floor_div(block_z, SparseVoxelOctree::REGION_SIZE);
+
+	auto it = m_far_field.find(Chunk::get_coord_key(region_x, region_y, region_z));
+
+	if (it == m_far_field.end())
+	{
+		return BLOCK_AIR;
+	}
+
+	return it->second->get_block_type(block_x - region_x * SparseVoxelOctree::REGION_SIZE, block_y - region_y * SparseVoxelOctree::REGION_SIZE,
+		block_z - region_z * SparseVoxelOctree::REGION_SIZE, lod);
+}
+
+void World::submit_chunk_update(ChunkUpdate* chunk_update)
+{
+	auto job = [this, chunk_update](int worker)
+	{
+		// Updates for chunks that were unloaded while the update waited are never started
+		if (chunk_update->get_cancellation_token().cancelled())
+		{
+			++m_updates_skipped;
+		}
+		else
+		{
 			{
-				it_y = it_x->second.erase(it_y);
-				del_y = false;
+				EpochManager::Guard guard{m_epochs, m_worker_participants[worker]};
+				chunk_update->run();
 			}
-			else
+
+			if (!chunk_update->complete())
 			{
-				++it_y;
+				++m_updates_aborted;
 			}
 		}
 
-		if (del_x)
+		m_completion_queue.push(chunk_update);
+	};
+
+	if (chunk_update->is_prefetch())
+	{
+		m_jobs.submit_background(std::move(job));
+	}
+	else
+	{
+		m_jobs.submit(std::move(job));
+	}
+}
+
+void World::upload_meshes()
+{
+	auto distance = [this](const ChunkUpdate* chunk_update)
+	{
+		int x = chunk_update->get_x() - m_center_x;
+		int y = chunk_update->get_y() - m_center_y;
+		int z = chunk_update->get_z() - m_center_z;
+		return x * x + y * y + z * z;
+	};
+
+	// Nearest last, so that they come off the back first
+	std::sort(m_completed_chunk_updates.begin(), m_completed_chunk_updates.end(), [&distance](const ChunkUpdate* a, const ChunkUpdate* b)
+	{
+		return distance(a) > distance(b);
+	});
+
+	auto start = std::chrono::steady_clock::now();
+	double elapsed = 0.0;
+	bool uploaded = false;
+
+	// Meshes are uploaded while their estimated cost fits in what is left of the budget. At
+	// least one is uploaded every frame so that the backlog always drains, however small the
+	// budget. Cancelled updates upload nothing, so they don't count.
+	while (!m_completed_chunk_updates.empty())
+	{
+		auto chunk_update = m_completed_chunk_updates.back();
+		auto size = chunk_update->get_mesh_size();
+		bool cancelled = chunk_update->get_cancellation_token().cancelled();
+
+		if (!cancelled && uploaded && elapsed + m_upload_nanoseconds_per_byte * size / 1000000.0 > m_mesh_upload_budget)
 		{
-			it_x = m_chunks.erase(it_x);
-			del_x = false;
+			break;
 		}
-		else
+
+		m_completed_chunk_updates.pop_back();
+		--m_num_running_updates;
+
+		auto upload_start = std::chrono::steady_clock::now();
+		process_completed_chunk_update(chunk_update);
+		auto upload_end = std::chrono::steady_clock::now();
+
+		recycle_chunk_update(chunk_update);
+		elapsed = std::chrono::duration<double, std::milli>(upload_end - start).count();
+
+		if (cancelled)
 		{
-			++it_x;
+			continue;
 		}
-	}
-}
 
-void World::load_chunk(int chunk_x, int chunk_y, int chunk_z)
-{
-	auto p1 = m_chunks.emplace(chunk_x, std::unordered_map<int, std::unordered_map<int, std::unique_ptr<Chunk>>>{});
-	auto p2 = p1.first->second.emplace(chunk_y, std::unordered_map<int, std::unique_ptr<Chunk>>{});
-	p2.first->second.emplace(chunk_z, std::make_unique<Chunk>(chunk_x, chunk_y, chunk_z));
-}
+		// The cost per byte is a moving average, so one slow upload doesn't stall the next frames
+		if (size > 0)
+		{
+			double nanoseconds_per_byte = std::chrono::duration<double, std::nano>(upload_end - upload_start).count() / size;
+			m_upload_nanoseconds_per_byte += (nanoseconds_per_byte - m_upload_nanoseconds_per_byte) * UPLOAD_COST_SMOOTHING;
+		}
 
-Chunk* World::get_block_chunk(int block_x, int block_y, int block_z) const
-{
-	int chunk_x = (block_x < 0 ? block_x - WorldConstants::CHUNK_SIZE + 1 : block_x) / WorldConstants::CHUNK_SIZE;
-	int chunk_y = (block_y < 0 ? block_y - WorldConstants::CHUNK_SIZE + 1 : block_y) / WorldConstants::CHUNK_SIZE;
-	int chunk_z = (block_z < 0 ? block_z - WorldConstants::CHUNK_SIZE + 1 : block_z) / WorldConstants::CHUNK_SIZE;
+		uploaded = true;
+	}
 
-	return get_chunk(chunk_x, chunk_y, chunk_z);
+	m_last_upload_milliseconds = elapsed;
 }
 
-Chunk* World::get_chunk(int chunk_x, int chunk_y, int chunk_z) const
+void World::prefetch_chunks(const glm::vec3& center, const glm::vec3& velocity)
 {
-	auto itx = m_chunks.find(chunk_x);
+	float speed = glm::length(velocity);
 
-	if (itx == m_chunks.end())
+	if (speed < MIN_PREFETCH_SPEED || m_num_prefetches >= static_cast<std::size_t>(m_jobs.get_num_workers()))
 	{
-		return nullptr;
+		return;
 	}
 
-	auto ity = itx->second.find(chunk_y);
+	// The horizon covers the same time ahead at any speed, up to a limit on how many chunks
+	// are generated ahead of the player
+	const float chunk_size = static_cast<float>(WorldConstants::CHUNK_SIZE);
+	float horizon = std::min(speed * PREFETCH_SECONDS, MAX_PREFETCH_CHUNKS * chunk_size);
+	auto direction = velocity / speed;
+
+	int load_distance = m_render_distance + GENERATION_MARGIN;
+	auto load_box = ChunkBox::around(m_center_x, m_center_y, m_center_z, load_distance);
 
-	if (ity == itx->second.end())
+	// Walks the predicted path a chunk at a time, nearest first, prefetching the chunks that
+	// would be loaded if the player were there. Chunks already in the world, in the cache or
+	// being prefetched are skipped, so each step only adds the slabs it moved into.
+	for (float distance = chunk_size; distance <= horizon; distance += chunk_size)
 	{
-		return nullptr;
-	}
+		auto position = center + direction * distance;
+		int x = Chunk::get_chunk_coord(static_cast<int>(std::floor(position.x)));
+		int y = Chunk::get_chunk_coord(static_cast<int>(std::floor(position.y)));
+		int z = Chunk::get_chunk_coord(static_cast<int>(std::floor(position.z)));
 
-	auto itz = ity->second.find(chunk_z);
+		bool full = false;
 
-	if (itz == ity->second.end())
-	{
-		return nullptr;
+		ChunkBox::around(x, y, z, load_distance).for_each_outside(load_box, [this, &full](int x, int y, int z)
+		{
+			if (full || get_chunk(x, y, z) || m_chunk_cache.contains(x, y, z) || m_prefetching.count(Chunk::get_coord_key(x, y, z)))
+			{
+				return;
+			}
+
+			auto chunk = std::make_unique<Chunk>(x, y, z);
+			chunk->set_prefetched(true);
+
+			auto chunk_update = create_chunk_update(*chunk);
+			chunk_update->set_prefetch(true);
+			submit_chunk_update(chunk_update);
+			chunk->begin_update(&chunk_update->get_cancellation_token());
+
+			m_prefetching.emplace(Chunk::get_coord_key(x, y, z), std::move(chunk));
+			++m_prefetch_stats.issued;
+
+			full = ++m_num_prefetches >= static_cast<std::size_t>(m_jobs.get_num_workers());
+		});
+
+		if (full)
+		{
+			return;
+		}
 	}
+}
 
-	return itz->second.get();
+void World::run_compression(Compression compression)
+{
+	compression.compressed = BlockData::create(*compression.block_data);
+	compression.compressed->compress();
+
+	std::lock_guard<decltype(m_compressions_mutex)> lock(m_compressions_mutex);
+	m_completed_compressions.push_back(std::move(compression));
 }
 
-void World::for_each_chunk(std::function<bool(Chunk*, int, int, int)> callback, bool skip_not_filled)
+void World::queue_cold_chunk_compressions(std::chrono::steady_clock::time_point now)
 {
-	for (auto& x : m_chunks)
+	for_each_chunk([this](Chunk* chunk, int x, int y, int z)
 	{
-		for (auto& y : x.second)
+		// Chunks are only queued once, on the second they become cold. If they are touched
+		// again they are decompressed and their idle time starts over.
+		if (chunk->update_idle_seconds() == COLD_CHUNK_SECONDS)
 		{
-			for (auto& z : y.second)
+			auto block_data = chunk->get_block_data();
+
+			// Compression runs in the background so it never delays chunk updates
+			if (!block_data->is_uniform() && !block_data->is_compressed())
 			{
-				if (z.second->filled())
-				{
-					if (!callback(z.second.get(), x.first, y.first, z.first))
-					{
-						return;
-					}
-				}
-				else if (!skip_not_filled && !callback(z.second.get(), x.first, y.first, z.first))
+				Compression compression{x, y, z, std::move(block_data), nullptr};
+
+				m_jobs.submit_background([this, compression](int)
 				{
-					return;
-				}
+					run_compression(compression);
+				});
 			}
 		}
-	}
+
+		return true;
+	});
+
+	auto decompressions = BlockData::get_total_decompressions();
+	auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - m_last_cold_check);
+
+	m_decompressions_per_second = static_cast<double>(decompressions - m_last_decompressions) / elapsed.count();
+	m_last_decompressions = decompressions;
+	m_last_cold_check = now;
 }
 
-World::ChunkUpdateArray::value_type* World::get_chunk_update_slot(bool low_priority)
+void World::process_completed_compressions()
 {
-	// No need for read locking since only this thread writes to it.
+	std::vector<Compression> completed;
+
+	{
+		std::lock_guard<decltype(m_compressions_mutex)> lock(m_compressions_mutex);
+		completed.swap(m_completed_compressions);
+	}
 
-	for (auto& chunk_update : (low_priority ? m_chunk_updates_low_priority : m_chunk_updates))
+	for (auto& compression : completed)
 	{
-		if (!chunk_update.first)
+		auto chunk = get_chunk(compression.chunk_x, compression.chunk_y, compression.chunk_z);
+
+		// Any write to the chunk since the compression was queued replaced its block data,
+		// because the compression held a reference to it.
+		if (chunk && chunk->get_block_data() == compression.block_data)
 		{
-			return &chunk_update;
+			chunk->set_block_data(std::move(compression.compressed));
 		}
 	}
-
-	return nullptr;
 }
 
-World::ChunkUpdateArray::value_type* World::get_next_chunk_update()
+void World::update_loaded_chunks(const glm::vec3& center)
 {
-	for (auto& chunk_update : m_chunk_updates)
+	int x = static_cast<int>((center.x < 0.0f) ? center.x - WorldConstants::CHUNK_SIZE - 1.0f : center.x);
+	int y = static_cast<int>((center.y < 0.0f) ? center.y - WorldConstants::CHUNK_SIZE - 1.0f : center.y);
+	int z = static_cast<int>((center.z < 0.0f) ? center.z - WorldConstants::CHUNK_SIZE - 1.0f : center.z);
+
+	x /= WorldConstants::CHUNK_SIZE;
+	y /= WorldConstants::CHUNK_SIZE;
+	z /= WorldConstants::CHUNK_SIZE;
+
+	// Nothing changes until the center moves into another chunk
+	if (!m_reload_chunks && x == m_center_x && y == m_center_y && z == m_center_z)
 	{
-		std::lock_guard<decltype(chunk_update.second)> chunk_update_lock(chunk_update.second);
+		return;
+	}
 
-		if (chunk_update.first && !chunk_update.first->finished())
+	// Chunks are loaded just beyond the render distance but only unloaded once they are further
+	// away than the grid radius, so moving back and forth across a chunk boundary doesn't
+	// unload anything. Every coordinate in the grid's cube maps to its own slot, so after a
+	// pass over the cube each slot holds either nothing or the chunk for its coordinates.
+	// That still holds for the part of the cube that overlaps the previous one, so only the
+	// slabs that entered the unload and load cubes need visiting. A teleport, or a change to
+	// the render distance, leaves no overlap and the whole cube is visited.
+	int unload_distance = m_chunks.get_radius();
+
+	auto new_unload_box = ChunkBox::around(x, y, z, unload_distance);
+	auto new_load_box = ChunkBox::around(x, y, z, m_render_distance + GENERATION_MARGIN);
+	auto old_unload_box = m_reload_chunks ? ChunkBox::empty() : ChunkBox::around(m_center_x, m_center_y, m_center_z, unload_distance);
+	auto old_load_box = m_reload_chunks ? ChunkBox::empty() : ChunkBox::around(m_center_x, m_center_y, m_center_z, m_render_distance + GENERATION_MARGIN);
+	auto new_render_box = ChunkBox::around(x, y, z, m_render_distance);
+	auto old_render_box = m_reload_chunks ? new_render_box : ChunkBox::around(m_center_x, m_center_y, m_center_z, m_render_distance);
+
+	m_center_x = x;
+	m_center_y = y;
+	m_center_z = z;
+	m_reload_chunks = false;
+
+	new_unload_box.for_each_outside(old_unload_box, [this, &new_load_box](int x, int y, int z)
+	{
+		if (m_chunks.holds_other_chunk(x, y, z))
 		{
-			return &chunk_update;
+			unload_chunk(m_chunks.take_slot(x, y, z));
 		}
-	}
 
-	for (auto& chunk_update : m_chunk_updates_low_priority)
+		if (new_load_box.contains(x, y, z) && !m_chunks.get_slot(x, y, z))
+		{
+			load_chunk(x, y, z);
+		}
+	});
+
+	// Slots in the entering load slabs have either been visited above or were already in the
+	// unload cube, so they are empty or hold the right chunk
+	new_load_box.for_each_outside(old_load_box, [this](int x, int y, int z)
+	{
+		if (!m_chunks.get_slot(x, y, z))
+		{
+			load_chunk(x, y, z);
+		}
+	});
+
+	// Chunks that come within the render distance before they have been generated are holes
+	// the player can see. Reloads aren't counted, since there was no way to see them coming.
+	new_render_box.for_each_outside(old_render_box, [this](int x, int y, int z)
+	{
+		auto chunk = get_chunk(x, y, z);
+
+		if (!chunk || !chunk->filled())
+		{
+			++m_prefetch_stats.holes;
+		}
+	});
+
+	WorldGen::evict_column_heights(m_center_x, m_center_z, unload_distance);
+	unload_far_field_regions();
+}
+
+void World::load_chunk(int chunk_x, int chunk_y, int chunk_z)
+{
+	auto chunk = m_chunk_cache.take(chunk_x, chunk_y, chunk_z);
+
+	// A chunk still being prefetched is loaded as it is, and its update finishes in the grid
+	if (!chunk)
 	{
-		std::lock_guard<decltype(chunk_update.second)> chunk_update_lock(chunk_update.second);
+		auto it = m_prefetching.find(Chunk::get_coord_key(chunk_x, chunk_y, chunk_z));
 
-		if (chunk_update.first && !chunk_update.first->finished())
+		if (it != m_prefetching.end())
+		{
+			chunk = std::move(it->second);
+			m_prefetching.erase(it);
+		}
+		else
 		{
-			return &chunk_update;
+			chunk = std::make_unique<Chunk>(chunk_x, chunk_y, chunk_z);
 		}
 	}
 
-	return nullptr;
+	if (chunk->prefetched())
+	{
+		chunk->set_prefetched(false);
+		++(chunk->filled() ? m_prefetch_stats.hits : m_prefetch_stats.late);
+	}
+
+	chunk->set_dirty_list(&m_dirty_chunks);
+
+	auto loaded = chunk.get();
+	m_chunks.set_slot(chunk_x, chunk_y, chunk_z, std::move(chunk));
+
+	// Chunks from the cache arrive already generated
+	if (loaded->filled())
+	{
+		wake_neighbours(*loaded);
+	}
 }
 
-void World::process_completed_chunk_update(decltype(ChunkUpdateArray::value_type::first)& chunk_update)
+void World::unload_chunk(std::unique_ptr<Chunk> chunk)
 {
-	auto chunk = get_chunk(chunk_update->get_x(), chunk_update->get_y(), chunk_update->get_z());
+	chunk->set_dirty_list(nullptr);
+	chunk->cancel_update();
+
+	// A chunk with an update in flight is dropped rather than cached, since the update has just
+	// been cancelled.
+	if (chunk->filled() && !chunk->update_queued())
+	{
+		if (!m_cache_chunk_meshes)
+		{
+			chunk->clear_mesh();
+		}
+
+		chunk = m_chunk_cache.put(std::move(chunk));
+	}
 
 	if (!chunk)
 	{
-		// Chunk has been unloaded while we were updating it's data
 		return;
 	}
 
-	chunk->update_mesh(chunk_update->get_vertices().data(), chunk_update->get_indices().data(), chunk_update->get_num_vertices(), chunk_update->get_num_indices());
+	if (chunk->prefetched())
+	{
+		++m_prefetch_stats.wasted;
+	}
+
+	if (chunk->filled())
+	{
+		add_to_far_field(*chunk);
+	}
 
-	// If this chunk has just been filled, we need to update any adjacent chunks that are now
-	// completely surrounded. This is to achieve full obstruction culling for those chunks.
+	// The chunk update thread may still be reading the chunk
+	m_epochs.retire(std::move(chunk));
+}
 
-	auto update_chunk_if_surrounded = [this](int chunk_x, int chunk_y, int chunk_z)
+void World::add_to_far_field(const Chunk& chunk)
+{
+	int x = chunk.get_x();
+	int y = chunk.get_y();
+	int z = chunk.get_z();
+
+	// Block data is never written once shared, so the build can read it without a lock. A chunk
+	// unloaded again before its last build finished replaces the pending block data, and the
+	// older build is then ignored.
+	auto block_data = chunk.get_block_data();
+
+	// Far lookups read pending chunks a block at a time, which would decompress compressed
+	// blocks on every read, so they are decompressed once up front
+	if (block_data->is_compressed())
 	{
-		Chunk* chunk = get_chunk(chunk_x, chunk_y, chunk_z);
+		auto decompressed = BlockData::create(*block_data);
+		decompressed->decompress();
+		block_data = std::move(decompressed);
+	}
 
-		if (!chunk)
+	m_far_field_pending[Chunk::get_coord_key(x, y, z)] = block_data;
+
+	m_jobs.submit_background([this, x, y, z, block_data](int)
+	{
+		run_far_field_build({x, y, z, block_data, {BLOCK_AIR, nullptr}});
+	});
+}
+
+void World::run_far_field_build(FarFieldChunk far_field_chunk)
+{
+	far_field_chunk.node = SparseVoxelOctree::build_chunk(*far_field_chunk.block_data);
+
+	std::lock_guard<decltype(m_far_field_mutex)> lock(m_far_field_mutex);
+	m_completed_far_field_chunks.push_back(std::move(far_field_chunk));
+}
+
+void World::process_completed_far_field_chunks()
+{
+	std::vector<FarFieldChunk> completed;
+
+	{
+		std::lock_guard<decltype(m_far_field_mutex)> lock(m_far_field_mutex);
+		completed.swap(m_completed_far_field_chunks);
+	}
+
+	for (auto& far_field_chunk : completed)
+	{
+		// Builds for chunks whose region has been unloaded, or that were unloaded again since,
+		// no longer have a matching pending entry
+		auto pending = m_far_field_pending.find(Chunk::get_coord_key(far_field_chunk.chunk_x, far_field_chunk.chunk_y, far_field_chunk.chunk_z));
+
+		if (pending == m_far_field_pending.end() || pending->second != far_field_chunk.block_data)
 		{
-			return;
+			continue;
 		}
 
-		Chunk* adjacent = get_chunk(chunk_x - 1, chunk_y, chunk_z);
-		if (adjacent && !adjacent->filled())
+		m_far_field_pending.erase(pending);
+
+		int region_x = floor_div(far_field_chunk.chunk_x, SparseVoxelOctree::REGION_CHUNKS);
+		int region_y = floor_div(far_field_chunk.chunk_y, SparseVoxelOctree::REGION_CHUNKS);
+		int region_z = floor_div(far_field_chunk.chunk_z, SparseVoxelOctree::REGION_CHUNKS);
+
+		auto& region = m_far_field[Chunk::get_coord_key(region_x, region_y, region_z)];
+
+		if (!region)
 		{
-			return;
+			region = std::make_unique<SparseVoxelOctree>();
 		}
 
-		adjacent = get_chunk(chunk_x + 1, chunk_y, chunk_z);
-		if (adjacent && !adjacent->filled())
+		region->set_chunk(far_field_chunk.chunk_x - region_x * SparseVoxelOctree::REGION_CHUNKS, far_field_chunk.chunk_y - region_y * SparseVoxelOctree::REGION_CHUNKS,
+			far_field_chunk.chunk_z - region_z * SparseVoxelOctree::REGION_CHUNKS, std::move(far_field_chunk.node));
+	}
+}
+
+void World::unload_far_field_regions()
+{
+	auto out_of_range = [this](int region_x, int region_y, int region_z)
+	{
+		auto distance = [](int region, int center)
 		{
-			return;
-		}
+			int first = region * SparseVoxelOctree::REGION_CHUNKS;
+			int last = first + SparseVoxelOctree::REGION_CHUNKS - 1;
+			return center < first ? first - center : (center > last ? center - last : 0);
+		};
+
+		return distance(region_x, m_center_x) > m_far_field_distance ||
+			distance(region_y, m_center_y) > m_far_field_distance ||
+			distance(region_z, m_center_z) > m_far_field_distance;
+	};
 
-		adjacent = get_chunk(chunk_x, chunk_y - 1, chunk_z);
-		if (adjacent && !adjacent->filled())
+	for (auto it = m_far_field.begin(); it != m_far_field.end();)
+	{
+		if (out_of_range(get_coord_from_key(it->first, 42), get_coord_from_key(it->first, 21), get_coord_from_key(it->first, 0)))
 		{
-			return;
+			it = m_far_field.erase(it);
 		}
-
-		adjacent = get_chunk(chunk_x, chunk_y + 1, chunk_z);
-		if (adjacent && !adjacent->filled())
+		else
 		{
-			return;
+			++it;
 		}
+	}
+
+	// Dropping the pending entry also drops the build's result once it finishes
+	for (auto it = m_far_field_pending.begin(); it != m_far_field_pending.end();)
+	{
+		int region_x = floor_div(get_coord_from_key(it->first, 42), SparseVoxelOctree::REGION_CHUNKS);
+		int region_y = floor_div(get_coord_from_key(it->first, 21), SparseVoxelOctree::REGION_CHUNKS);
+		int region_z = floor_div(get_coord_from_key(it->first, 0), SparseVoxelOctree::REGION_CHUNKS);
 
-		adjacent = get_chunk(chunk_x, chunk_y, chunk_z - 1);
-		if (adjacent && !adjacent->filled())
+		if (out_of_range(region_x, region_y, region_z))
 		{
-			return;
+			it = m_far_field_pending.erase(it);
 		}
-
-		adjacent = get_chunk(chunk_x, chunk_y, chunk_z + 1);
-		if (adjacent && !adjacent->filled())
+		else
 		{
-			return;
+			++it;
 		}
+	}
+}
 
-		chunk->set_up_to_date(false);
-	};
+Chunk* World::get_block_chunk(int block_x, int block_y, int block_z) const
+{
+	return get_chunk(Chunk::get_chunk_coord(block_x), Chunk::get_chunk_coord(block_y), Chunk::get_chunk_coord(block_z));
+}
+
+Chunk* World::get_chunk(int chunk_x, int chunk_y, int chunk_z) const
+{
+	return m_chunks.get(chunk_x, chunk_y, chunk_z);
+}
 
-	if (!chunk->filled())
+void World::for_each_chunk(std::function<bool(Chunk*, int, int, int)> callback, bool skip_not_filled)
+{
+	m_chunks.for_each([&callback](Chunk* chunk)
 	{
-		chunk->set_filled(true);
+		return callback(chunk, chunk->get_x(), chunk->get_y(), chunk->get_z());
+	}, skip_not_filled ? Chunk::FILLED : 0);
+}
 
-		update_chunk_if_surrounded(chunk->get_x() - 1, chunk->get_y(), chunk->get_z());
-		update_chunk_if_surrounded(chunk->get_x() + 1, chunk->get_y(), chunk->get_z());
-		update_chunk_if_surrounded(chunk->get_x(), chunk->get_y() - 1, chunk->get_z());
-		update_chunk_if_surrounded(chunk->get_x(), chunk->get_y() + 1, chunk->get_z());
-		update_chunk_if_surrounded(chunk->get_x(), chunk->get_y(), chunk->get_z() - 1);
-		update_chunk_if_surrounded(chunk->get_x(), chunk->get_y(), chunk->get_z() + 1);
+ChunkUpdate* World::create_chunk_update(const Chunk& chunk)
+{
+	if (m_free_chunk_updates.empty())
+	{
+		m_chunk_updates.push_back(std::make_unique<ChunkUpdate>(chunk.get_block_data(), chunk.get_version(), chunk.get_x(), chunk.get_y(), chunk.get_z(), !chunk.filled()));
+		return m_chunk_updates.back().get();
 	}
 
-	if (!chunk->reupdate())
+	auto chunk_update = m_free_chunk_updates.back();
+	m_free_chunk_updates.pop_back();
+	chunk_update->reset(chunk.get_block_data(), chunk.get_version(), chunk.get_x(), chunk.get_y(), chunk.get_z(), !chunk.filled());
+
+	return chunk_update;
+}
+
+void World::process_completed_chunk_update(const ChunkUpdate* chunk_update)
+{
+	// Chunks that leave the grid cancel their update, so the chunk is only looked up for updates
+	// that weren't cancelled. A chunk loaded again since is a different chunk.
+	if (chunk_update->get_cancellation_token().cancelled())
 	{
-		chunk->set_up_to_date(true);
+		if (chunk_update->complete())
+		{
+			++m_updates_discarded;
+		}
+
+		return;
 	}
-	
-	chunk->set_update_queued(false);
-	chunk->set_low_priority_update(false);
+
+	auto chunk = get_chunk(chunk_update->get_x(), chunk_update->get_y(), chunk_update->get_z());
+
+	if (chunk_update->is_fill())
+	{
+		// Prefetched chunks that haven't been loaded yet go into the cache once generated
+		std::unique_ptr<Chunk> prefetched;
+
+		if (!chunk)
+		{
+			auto it = m_prefetching.find(Chunk::get_coord_key(chunk_update->get_x(), chunk_update->get_y(), chunk_update->get_z()));
+			prefetched = std::move(it->second);
+			m_prefetching.erase(it);
+			chunk = prefetched.get();
+		}
+
+		chunk->set_block_data(chunk_update->get_generated_block_data());
+		chunk->finish_update(chunk_update->get_version());
+		++m_num_generations;
+
+		if (prefetched)
+		{
+			unload_chunk(std::move(prefetched));
+		}
+		else
+		{
+			wake_neighbours(*chunk);
+		}
+
+		return;
+	}
+
+	// The mesh is still shown even if the chunk changed while it was being built, but the
+	// chunk then finishes the update as dirty so that it gets updated again.
+	chunk->update_mesh(chunk_update->get_vertices().data(), chunk_update->get_indices().data(), chunk_update->get_num_vertices(), chunk_update->get_num_indices());
+	chunk->finish_update(chunk_update->get_version());
+	++m_num_meshes;
 }
+
+void World::recycle_chunk_update(ChunkUpdate* chunk_update)
+{
+	// Drop the finished update's references to block data while it waits to be reused
+	chunk_update->reset(nullptr, 0, 0, 0, 0, false);
+	m_free_chunk_updates.push_back(chunk_update);
+}
+
+bool World::neighbours_generated(const Chunk& chunk) const
+{
+	auto generated = [this, &chunk](int offset_x, int offset_y, int offset_z)
+	{
+		auto neighbour = get_chunk(chunk.get_x() + offset_x, chunk.get_y() + offset_y, chunk.get_z() + offset_z);
+		return neighbour && neighbour->filled();
+	};
+
+	return generated(-1, 0, 0) && generated(1, 0, 0) && generated(0, -1, 0) && generated(0, 1, 0) && generated(0, 0, -1) && generated(0, 0, 1);
+}
+
+void World::wake_neighbours(const Chunk& chunk)
+{
+	auto wake = [this, &chunk](int offset_x, int offset_y, int offset_z)
+	{
+		auto neighbour = get_chunk(chunk.get_x() + offset_x, chunk.get_y() + offset_y, chunk.get_z() + offset_z);
+
+		if (neighbour && neighbour->needs_update())
+		{
+			m_dirty_chunks.push_back(neighbour);
+		}
+	};
+
+	wake(-1, 0, 0);
+	wake(1, 0, 0);
+	wake(0, -1, 0);
+	wake(0, 1, 0);
+	wake(0, 0, -1);
+	wake(0, 0, 1);
+}
\ No newline at end of file
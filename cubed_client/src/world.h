@@ -3,55 +3,260 @@
 
 #include "block_type.h"
 #include "block_info.h"
+#include "chunk_cache.h"
+#include "chunk_grid.h"
 #include "chunk_update.h"
-#include <array>
+#include "chunk_update_queue.h"
+#include "completion_queue.h"
+#include "dirty_chunk_list.h"
+#include "edit_batch.h"
+#include "epoch_manager.h"
+#include "job_system.h"
+#include "sparse_voxel_octree.h"
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <glm/include/glm.hpp>
 #include <memory>
 #include <mutex>
-#include <thread>
 #include <unordered_map>
-
-class Chunk;
+#include <vector>
 
 class World
 {
 public:
+	struct ColdTierStats
+	{
+		std::size_t compressed_bytes;
+		double decompressions_per_second;
+	};
+
+	// Chunk updates wasted on chunks that were unloaded before the update was processed. Skipped
+	// updates were dropped before they started and aborted ones stopped part way through, but
+	// discarded ones had already finished.
+	struct CancellationStats
+	{
+		unsigned long long skipped;
+		unsigned long long aborted;
+		unsigned long long discarded;
+	};
+
+	// A chunk is meshed once its neighbours have been generated, so during loading meshes should
+	// be close to one per generated chunk. More than that means chunks are being remeshed.
+	struct PipelineStats
+	{
+		unsigned long long generations;
+		unsigned long long meshes;
+	};
+
+	// Chunks generated ahead of the player along its velocity. Hits had been generated by the
+	// time they were loaded, late ones were still generating and wasted ones were evicted from
+	// the cache without being loaded. Holes count every chunk that came within the render
+	// distance before it had been generated, prefetched or not.
+	struct PrefetchStats
+	{
+		unsigned long long issued;
+		unsigned long long hits;
+		unsigned long long late;
+		unsigned long long wasted;
+		unsigned long long holes;
+	};
+
+	// Meshes waiting to be uploaded, the time spent uploading them in the last frame and the
+	// measured upload cost
+	struct MeshUploadStats
+	{
+		std::size_t backlog;
+		double last_frame_milliseconds;
+		double nanoseconds_per_byte;
+	};
+
+	struct AllocationStats
+	{
+		ObjectPool::Stats chunks;
+		ObjectPool::Stats block_data;
+		WordBufferPool::Stats block_buffers;
+		std::size_t chunk_updates;
+	};
+
 	World(int render_distance);
 	~World();
 
-	void update(const glm::vec3& center);
+	// Chunk updates are prioritised by distance from the center and whether they are in view.
+	// Chunks ahead of the center are generated early based on the velocity.
+	void update(const glm::vec3& center, const glm::vec3& velocity, const glm::mat4& view_projection);
 	void render();
 
-	void set_render_distance(int render_distance) { m_render_distance = render_distance; }
+	void set_render_distance(int render_distance);
+	void set_far_field_distance(int far_field_distance) { m_far_field_distance = far_field_distance; }
+	void set_cache_chunk_meshes(bool cache_chunk_meshes) { m_cache_chunk_meshes = cache_chunk_meshes; }
+
+	// Milliseconds per frame to spend uploading chunk meshes
+	void set_mesh_upload_budget(double mesh_upload_budget) { m_mesh_upload_budget = mesh_upload_budget; }
+
+	const ChunkCache& get_chunk_cache() const { return m_chunk_cache; }
+	AllocationStats get_allocation_stats() const { return {Chunk::get_pool().get_stats(), BlockData::get_pool().get_stats(), BlockData::get_buffer_pool().get_stats(), m_chunk_updates.size()}; }
+	MeshUploadStats get_mesh_upload_stats() const { return {m_completed_chunk_updates.size(), m_last_upload_milliseconds, m_upload_nanoseconds_per_byte}; }
+	const PrefetchStats& get_prefetch_stats() const { return m_prefetch_stats; }
+	PipelineStats get_pipeline_stats() const { return {m_num_generations, m_num_meshes}; }
+	CancellationStats get_cancellation_stats() const { return {m_updates_skipped, m_updates_aborted, m_updates_discarded}; }
+	ColdTierStats get_cold_tier_stats() const { return {BlockData::get_total_compressed_bytes(), m_decompressions_per_second}; }
 
 	BlockType get_block_type(int block_x, int block_y, int block_z) const;
 	auto& get_block_properties(BlockType type) { return m_block_info.get_properties(type); }
 	bool is_block_at(int block_x, int block_y, int block_z) const { return get_block_type(block_x, block_y, block_z) != BLOCK_AIR; }
 
+	// Finds the first solid block in the box (inclusive), searching in x, then y, then z order.
+	// Whole columns of each chunk are tested at once using the chunks' solid masks.
+	bool find_solid_block(int low_x, int low_y, int low_z, int high_x, int high_y, int high_z, int& block_x, int& block_y, int& block_z) const;
+
+	// Returns null if the chunk isn't loaded. Safe to call from any thread, but threads other
+	// than the main thread must hold a guard from the world's epoch manager.
+	std::shared_ptr<const BlockData> get_chunk_block_data(int chunk_x, int chunk_y, int chunk_z) const;
+
+	// Applies all edits in the batch, updating each affected chunk and its neighbours once
+	void edit_region(const EditBatch& batch);
+
+	// Like get_block_type but falls back to the chunk cache and then the read only far field
+	// data for chunks that are no longer loaded. Only safe to call from the main thread.
+	BlockType get_far_block_type(int block_x, int block_y, int block_z, int lod = 0) const;
+
 private:
-	typedef std::array<std::pair<std::unique_ptr<ChunkUpdate>, std::mutex>, 10> ChunkUpdateArray;
+	friend class BlockAccessor;
+	friend class Benchmark;
+
+	struct Compression
+	{
+		int chunk_x;
+		int chunk_y;
+		int chunk_z;
+		std::shared_ptr<const BlockData> block_data;
+		std::shared_ptr<BlockData> compressed;
+	};
+
+	struct FarFieldChunk
+	{
+		int chunk_x;
+		int chunk_y;
+		int chunk_z;
+		std::shared_ptr<const BlockData> block_data;
+		SparseVoxelOctree::Node node;
+	};
 
-	void chunk_update_thread();
+	void submit_chunk_update(ChunkUpdate* chunk_update);
+	void upload_meshes();
+	void prefetch_chunks(const glm::vec3& center, const glm::vec3& velocity);
+	void run_compression(Compression compression);
+	void queue_cold_chunk_compressions(std::chrono::steady_clock::time_point now);
+	void process_completed_compressions();
 	void update_loaded_chunks(const glm::vec3& center);
 	void load_chunk(int chunk_x, int chunk_y, int chunk_z);
+	void unload_chunk(std::unique_ptr<Chunk> chunk);
+	void add_to_far_field(const Chunk& chunk);
+	void run_far_field_build(FarFieldChunk far_field_chunk);
+	void process_completed_far_field_chunks();
+	void unload_far_field_regions();
 	Chunk* get_block_chunk(int block_x, int block_y, int block_z) const;
 	Chunk* get_chunk(int chunk_x, int chunk_y, int chunk_z) const;
 	void for_each_chunk(std::function<bool(Chunk*, int, int, int)> callback, bool skip_not_filled = true);
-	ChunkUpdateArray::value_type* get_chunk_update_slot(bool low_priority);
-	ChunkUpdateArray::value_type* get_next_chunk_update();
-	void process_completed_chunk_update(decltype(ChunkUpdateArray::value_type::first)& chunk_update);
+	ChunkUpdate* create_chunk_update(const Chunk& chunk);
+	void process_completed_chunk_update(const ChunkUpdate* chunk_update);
+	void recycle_chunk_update(ChunkUpdate* chunk_update);
+
+	// Chunks are only meshed once all six neighbours have been generated, so that the faces on
+	// their boundaries are culled correctly the first time
+	bool neighbours_generated(const Chunk& chunk) const;
+
+	// Puts the chunk's neighbours back in the dirty list once it has been generated, in case
+	// they were waiting on it to be meshed
+	void wake_neighbours(const Chunk& chunk);
 
 	int m_render_distance;
-	std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::unique_ptr<Chunk>>>> m_chunks;
-	ChunkUpdateArray m_chunk_updates;
-	ChunkUpdateArray m_chunk_updates_low_priority;
-	std::atomic_bool m_run_chunk_updates;
-	std::thread m_chunk_update_thread;
+	int m_center_x;
+	int m_center_y;
+	int m_center_z;
+	bool m_reload_chunks;
+	DirtyChunkList m_dirty_chunks;
+	EpochManager m_epochs;
+	ChunkGrid m_chunks;
+	int m_far_field_distance;
+	std::unordered_map<std::uint64_t, std::unique_ptr<SparseVoxelOctree>> m_far_field;
+
+	// Unloaded chunks whose octree is still being built in the background. Far lookups read
+	// their blocks directly until the octree is in place.
+	std::unordered_map<std::uint64_t, std::shared_ptr<const BlockData>> m_far_field_pending;
+	std::vector<FarFieldChunk> m_completed_far_field_chunks;
+	std::mutex m_far_field_mutex;
+	ChunkCache m_chunk_cache;
+	bool m_cache_chunk_meshes;
+	ChunkUpdateQueue m_update_queue;
+
+	// Every chunk update created so far. Updates are passed to jobs and back by pointer and are
+	// reused once finished, so they live as long as the world.
+	std::vector<std::unique_ptr<ChunkUpdate>> m_chunk_updates;
+	std::vector<ChunkUpdate*> m_free_chunk_updates;
+
+	// Mesh updates count as running until their mesh has been uploaded, so a growing upload
+	// backlog holds back new updates instead of piling up finished ones
+	std::size_t m_num_running_updates;
+	std::atomic<unsigned long long> m_updates_skipped;
+	std::atomic<unsigned long long> m_updates_aborted;
+	unsigned long long m_updates_discarded;
+	unsigned long long m_num_generations;
+	unsigned long long m_num_meshes;
+
+	// Chunks outside the grid whose prefetch is in flight. Finished prefetches go into the
+	// chunk cache.
+	std::unordered_map<std::uint64_t, std::unique_ptr<Chunk>> m_prefetching;
+	std::size_t m_num_prefetches;
+	PrefetchStats m_prefetch_stats;
+	double m_mesh_upload_budget;
+	double m_upload_nanoseconds_per_byte;
+	double m_last_upload_milliseconds;
+	CompletionQueue<ChunkUpdate> m_completion_queue;
+
+	// Finished mesh updates waiting for their mesh to be uploaded
+	std::vector<ChunkUpdate*> m_completed_chunk_updates;
+	std::vector<Compression> m_completed_compressions;
+	std::mutex m_compressions_mutex;
+	std::chrono::steady_clock::time_point m_last_cold_check;
+	unsigned long long m_last_decompressions;
+	double m_decompressions_per_second;
 	const BlockInfo m_block_info;
+	std::vector<int> m_worker_participants;
+
+	// Declared last so that the workers are stopped before anything they use is destroyed
+	JobSystem m_jobs;
+
+	// Enough to keep every worker busy while leaving the order to the update queue
+	static const int MAX_RUNNING_UPDATES_PER_WORKER = 2;
+
+	// How many chunks beyond the render distance a chunk has to be before it is unloaded
+	static const int UNLOAD_DISTANCE_MARGIN = 2;
+
+	// Chunks this far beyond the render distance are generated but not meshed, so that every
+	// chunk within the render distance has all six neighbours. Must be less than the unload
+	// margin.
+	static const int GENERATION_MARGIN = 1;
+
+	// Prefetching looks this many seconds ahead, but never more than the given number of chunks
+	static const float PREFETCH_SECONDS;
+	static const float MAX_PREFETCH_CHUNKS;
+
+	// Below this speed, in blocks per second, there is no useful direction to prefetch in
+	static const float MIN_PREFETCH_SPEED;
+
+	static const double DEFAULT_MESH_UPLOAD_BUDGET;
+	static const double INITIAL_UPLOAD_NANOSECONDS_PER_BYTE;
+
+	// Weight of each new measurement in the moving average of the upload cost
+	static const double UPLOAD_COST_SMOOTHING;
+	static const int CHUNK_CACHE_CAPACITY = 2048;
 
-	const int MAX_CHUNK_MESH_UPDATES_PER_FRAME = 2;
+	// Seconds a chunk's blocks have to go untouched before they are compressed
+	static const int COLD_CHUNK_SECONDS = 30;
 };
 
 #endif
\ No newline at end of file
@@ -1,16 +1,41 @@
 #ifndef CUBED_WORLD_CONSTANTS_H
 #define CUBED_WORLD_CONSTANTS_H
 
+// Chunk dimensions and block index layout are chosen at compile time. Define CUBED_CHUNK_SIZE
+// as 16, 32 or 64 and CUBED_BLOCK_LAYOUT as LINEAR, Y_MAJOR or MORTON to override the defaults.
+//
+// An unpacked array of a chunk's blocks (BlockData::BlockArray) takes 16 KB at size 16, 128 KB
+// at 32 and 1 MB at 64, so it must never be put on the stack. Each chunk update holds one, as
+// does the scratch array of each thread that generates chunks or builds far field octrees.
+// Packed block data is usually far smaller.
+#ifndef CUBED_CHUNK_SIZE
+	#define CUBED_CHUNK_SIZE 16
+#endif
+
+#ifndef CUBED_BLOCK_LAYOUT
+	#define CUBED_BLOCK_LAYOUT LINEAR
+#endif
+
+enum class BlockLayout
+{
+	LINEAR,		// x, then z, then y. Columns are contiguous.
+	Y_MAJOR,	// y, then x, then z. Horizontal slices are contiguous.
+	MORTON		// Bits of x, z and y interleaved (Z-order curve)
+};
+
 namespace WorldConstants
 {
-	const int CHUNK_SIZE = 16;
+	const int CHUNK_SIZE = CUBED_CHUNK_SIZE;
 	const int CHUNK_NUM_BLOCKS = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+	const BlockLayout BLOCK_LAYOUT = BlockLayout::CUBED_BLOCK_LAYOUT;
 	const int VERTICES_PER_BLOCK = 24;
 	const int INDICES_PER_BLOCK = 36;
 	const int TEXTURE_STRIDE = 20;
 	const int TEXTURE_PADDING = 2;
 	const int TEXTURE_ATLAS_SIZE = 512;
 	const int TEXTURE_SIZE = 16;
+
+	static_assert(CHUNK_SIZE == 16 || CHUNK_SIZE == 32 || CHUNK_SIZE == 64, "CUBED_CHUNK_SIZE must be 16, 32 or 64");
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "heightmap_cache.h"
+#include "world_gen.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+
+namespace WorldGen
+{
+	std::shared_ptr<const ColumnHeights> HeightmapCache::get(int chunk_x, int chunk_z)
+	{
+		auto key = get_key(chunk_x, chunk_z);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_columns.find(key);
+
+			if (it != m_columns.end())
+			{
+				return it->second;
+			}
+		}
+
+		// Computed without holding the lock. If another thread computes the same column in the
+		// meantime, whichever finishes first wins.
+		auto column = std::make_shared<ColumnHeights>();
+		column->min_height = std::numeric_limits<int>::max();
+		column->max_height = std::numeric_limits<int>::min();
+
+		for (int x = 0; x < WorldConstants::CHUNK_SIZE; ++x)
+		{
+			for (int z = 0; z < WorldConstants::CHUNK_SIZE; ++z)
+			{
+				int height = get_height(chunk_x * WorldConstants::CHUNK_SIZE + x, chunk_z * WorldConstants::CHUNK_SIZE + z);
+				column->heights[x * WorldConstants::CHUNK_SIZE + z] = height;
+				column->min_height = std::min(column->min_height, height);
+				column->max_height = std::max(column->max_height, height);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_columns.emplace(key, std::move(column)).first->second;
+	}
+
+	void HeightmapCache::evict_outside(int center_x, int center_z, int radius)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (auto it = m_columns.begin(); it != m_columns.end();)
+		{
+			int chunk_x = static_cast<int>(static_cast<std::uint32_t>(it->first >> 32));
+			int chunk_z = static_cast<int>(static_cast<std::uint32_t>(it->first));
+
+			if (std::abs(chunk_x - center_x) > radius || std::abs(chunk_z - center_z) > radius)
+			{
+				it = m_columns.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef CUBED_WORLD_GEN_HEIGHTMAP_CACHE_H
+#define CUBED_WORLD_GEN_HEIGHTMAP_CACHE_H
+
+#include "../world_constants.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace WorldGen
+{
+	struct ColumnHeights
+	{
+		// Indexed by x * CHUNK_SIZE + z
+		std::array<int, WorldConstants::CHUNK_SIZE * WorldConstants::CHUNK_SIZE> heights;
+		int min_height;
+		int max_height;
+	};
+
+	// Terrain heights for chunk columns, shared by all the chunks stacked in a column.
+	// Safe to use from any thread.
+	class HeightmapCache
+	{
+	public:
+		std::shared_ptr<const ColumnHeights> get(int chunk_x, int chunk_z);
+
+		// Removes every column outside the given square of chunk columns
+		void evict_outside(int center_x, int center_z, int radius);
+
+	private:
+		static std::uint64_t get_key(int chunk_x, int chunk_z) { return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(chunk_x)) << 32) | static_cast<std::uint32_t>(chunk_z); }
+
+		std::unordered_map<std::uint64_t, std::shared_ptr<const ColumnHeights>> m_columns;
+		std::mutex m_mutex;
+	};
+}
+
+#endif
\ No newline at end of file
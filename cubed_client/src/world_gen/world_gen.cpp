@@ -8,19 +8,32 @@ namespace WorldGen
 	const int BASE_HEIGHT = 128;
 	const float AMPLITUDE = 16.0f;
 
+	HeightmapCache heightmap_cache;
+
 	void fill_chunk(BlockData& block_data, int start_x, int start_y, int start_z)
 	{
-		std::unique_lock<decltype(block_data.mutex)> lock(block_data.mutex);
+		auto column = get_column_heights(Chunk::get_chunk_coord(start_x), Chunk::get_chunk_coord(start_z));
+
+		// Most chunks are entirely above or below the surface. They are stored as a single
+		// block type without an index array.
+		BlockType uniform_type;
 
-		block_data.blocks.fill(BLOCK_AIR);
+		if (get_uniform_block_type(start_y, column->min_height, column->max_height, uniform_type))
+		{
+			block_data.fill(uniform_type);
+			return;
+		}
 
-		lock.unlock();
+		// Generate into a plain array and hand it over in one go so that the palette only has
+		// to be built once.
+		auto& blocks = BlockData::get_scratch_array();
+		blocks.fill(BLOCK_AIR);
 
 		for (int x = start_x; x < start_x + WorldConstants::CHUNK_SIZE; ++x)
 		{
 			for (int z = start_z; z < start_z + WorldConstants::CHUNK_SIZE; ++z)
 			{
-				int height = get_height(x, z);
+				int height = column->heights[(x - start_x) * WorldConstants::CHUNK_SIZE + z - start_z];
 
 				for (int y = start_y; y < start_y + WorldConstants::CHUNK_SIZE; ++y)
 				{
@@ -28,19 +41,27 @@ namespace WorldGen
 						break;
 
 					auto block_index = Chunk::get_block_index(x - start_x, y - start_y, z - start_z);
-					auto block_type = get_block_type(x, y, z, height);
-
-					lock.lock();
-					block_data.blocks[block_index] = block_type;
-					lock.unlock();
+					blocks[block_index] = get_block_type(x, y, z, height);
 				}
 			}
 		}
+
+		block_data.set_all(blocks);
 	}
 
 	glm::vec3 get_spawn_pos()
 	{
-		return glm::vec3(0.0f, static_cast<float>(get_height(0, 0) + 3), 0.0f);
+		return glm::vec3(0.0f, static_cast<float>(get_column_heights(0, 0)->heights[0] + 3), 0.0f);
+	}
+
+	std::shared_ptr<const ColumnHeights> get_column_heights(int chunk_x, int chunk_z)
+	{
+		return heightmap_cache.get(chunk_x, chunk_z);
+	}
+
+	void evict_column_heights(int center_x, int center_z, int radius)
+	{
+		heightmap_cache.evict_outside(center_x, center_z, radius);
 	}
 
 	int get_height(int x, int z)
@@ -58,6 +79,26 @@ namespace WorldGen
 		return static_cast<int>(BASE_HEIGHT + height * AMPLITUDE);
 	}
 
+	bool get_uniform_block_type(int start_y, int min_height, int max_height, BlockType& type)
+	{
+		int end_y = start_y + WorldConstants::CHUNK_SIZE - 1;
+
+		if (start_y > max_height)
+		{
+			type = BLOCK_AIR;
+			return true;
+		}
+
+		// Must match the layers in get_block_type
+		if (end_y < 40 || end_y <= min_height - 7)
+		{
+			type = BLOCK_STONE;
+			return true;
+		}
+
+		return false;
+	}
+
 	BlockType get_block_type(int x, int y, int z, int height)
 	{
 		if (y < 40)
@@ -3,12 +3,24 @@
 
 #include <glm/include/glm.hpp>
 #include "../chunk.h"
+#include "heightmap_cache.h"
+#include <memory>
 
 namespace WorldGen
 {
 	void fill_chunk(BlockData& block_data, int start_x, int start_y, int start_z);
 	glm::vec3 get_spawn_pos();
 	int get_height(int x, int z);
+
+	// Cached heights of a chunk column. Columns are evicted with evict_column_heights once
+	// their chunks have been unloaded.
+	std::shared_ptr<const ColumnHeights> get_column_heights(int chunk_x, int chunk_z);
+	void evict_column_heights(int center_x, int center_z, int radius);
+
+	// Returns true if every block in a chunk starting at start_y whose columns lie between the
+	// given heights is the same type.
+	bool get_uniform_block_type(int start_y, int min_height, int max_height, BlockType& type);
+
 	BlockType get_block_type(int x, int y, int z, int height);
 }
 